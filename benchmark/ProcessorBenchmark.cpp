@@ -0,0 +1,1266 @@
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <juce_events/juce_events.h>
+#include "../include/PluginProcessor.h"
+#include "../include/PluginEditor.h"
+#include "../include/DspCore.h"
+#include "../include/FastMath.h"
+#include "../include/GainKernels.h"
+#include "../include/RealtimeGuard.h"
+#include "../include/WorkerPool.h"
+#include "../include/PresetBank.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @brief Headless processBlock benchmark
+ *
+ * Instantiates AudioPluginProcessor without a host, prepares it for each
+ * requested sample rate / block size / channel count and times processBlock
+ * over a fixed number of samples.
+ *
+ * Usage:
+ *   MyVST3PluginBenchmark [--sample-rates 44100,48000,96000]
+ *                         [--block-sizes 32,64,128,256,512,1024,2048,4096]
+ *                         [--channels 1,2]    (up to 64, e.g. 1,2,6,12)
+ *                         [--samples 4194304]
+ *                         [--precision float|double|both]
+ *                         [--automate] [--offline]
+ *                         [--ir 8192] [--threads 3]
+ *   MyVST3PluginBenchmark --kernels [--block-sizes 512]
+ *   MyVST3PluginBenchmark --math
+ *   MyVST3PluginBenchmark --state
+ *   MyVST3PluginBenchmark --stress [--rounds 64] [--seed 1]
+ *   MyVST3PluginBenchmark --startup [--instances 200]
+ *   MyVST3PluginBenchmark --pathological [--block-sizes 512]
+ *   MyVST3PluginBenchmark --regression baseline.json [--tolerance 10] [--write-baseline]
+ *
+ * --ir loads a synthetic IR of the given length into the convolution stage and
+ * --threads enables that many worker threads; with wide layouts (e.g.
+ * --channels 16,64) this shows when the worker pool pays off.
+ * --kernels times the gain-ramp kernels for every instruction set this CPU
+ * supports on stereo blocks and reports the speed-up over the scalar kernel,
+ * then does the same for each DspCore variant built into this binary.
+ * --math times the FastMath approximations against the std/JUCE functions
+ * they replace and measures their maximum error over a dense sweep.
+ * --state times getStateInformation/setStateInformation against the legacy
+ * XML round trip, and program switching from a memory-mapped preset bank.
+ * --stress re-prepares the processor with random settings and feeds it blocks
+ * of random length (tiny, and larger than prepared, included) and content
+ * while automating parameters and sending MIDI CCs. Built with
+ * PLUGIN_REALTIME_CHECKS=ON, any allocation or lock inside processBlock
+ * aborts with a stack trace; non-finite output fails the run either way.
+ * --startup times what a host pays per instance when scanning or opening a
+ * session: construction, the queries a scanner makes, the first
+ * prepareToPlay and destruction.
+ * --pathological feeds a chain with look-ahead, oversampling and an IR with
+ * decaying tails, subnormals, NaN and Inf, and reports the cost per input
+ * against plain noise. Any non-finite output fails the run.
+ * --regression runs a fixed suite (processBlock at several block sizes and
+ * layouts, state save/restore, construction, editor paint), takes the median
+ * of a few runs per case and fails if any case is slower than the baseline
+ * file allows. --write-baseline records the results as the new baseline.
+ */
+namespace
+{
+    //==============================================================================
+    struct BenchmarkConfig
+    {
+        double sampleRate = 48000.0;
+        int blockSize = 512;
+        int numChannels = 2;
+        bool doublePrecision = false;
+        juce::int64 totalSamples = 1 << 22;
+        bool automate = false;
+        bool offline = false;
+        int impulseSamples = 0;    // synthetic IR length; 0 leaves the convolution bypassed
+        int numWorkerThreads = 0;
+    };
+
+    struct BenchmarkResult
+    {
+        double nsPerSample = 0.0;
+        double p50Micros = 0.0;
+        double p99Micros = 0.0;
+        double maxMicros = 0.0;
+        double realtimeCpuPercent = 0.0;
+        WorkerPool::Stats workerStats;
+    };
+
+    //==============================================================================
+    juce::Array<int> parseIntList(const juce::String& text)
+    {
+        juce::Array<int> values;
+
+        for (auto& token : juce::StringArray::fromTokens(text, ",", {}))
+            if (token.trim().isNotEmpty())
+                values.add(token.trim().getIntValue());
+
+        return values;
+    }
+
+    juce::AudioChannelSet channelSetFor(int numChannels)
+    {
+        return numChannels == 1 ? juce::AudioChannelSet::mono()
+                                : juce::AudioChannelSet::canonicalChannelSet(numChannels);
+    }
+
+    double percentile(const std::vector<double>& sorted, double fraction)
+    {
+        if (sorted.empty())
+            return 0.0;
+
+        auto index = static_cast<size_t>(fraction * static_cast<double>(sorted.size() - 1) + 0.5);
+        return sorted[std::min(index, sorted.size() - 1)];
+    }
+
+    //==============================================================================
+    /** Exponentially decaying stereo noise, roughly what a room or cabinet IR looks like. */
+    juce::AudioBuffer<float> makeImpulseResponse(juce::Random& random, int numSamples)
+    {
+        juce::AudioBuffer<float> impulse(2, numSamples);
+
+        for (int ch = 0; ch < impulse.getNumChannels(); ++ch)
+            for (int i = 0; i < numSamples; ++i)
+                impulse.setSample(ch, i, (random.nextFloat() * 2.0f - 1.0f)
+                                             * std::exp(-6.0f * static_cast<float>(i) / static_cast<float>(numSamples)));
+
+        return impulse;
+    }
+
+    /** Loads are decoded on a background thread and published on the message thread, so pump it until this one lands. */
+    bool loadImpulseResponseAndWait(AudioPluginProcessor& processor, juce::AudioBuffer<float>&& impulse, double sampleRate)
+    {
+        auto finished = std::make_shared<std::optional<bool>>();
+        processor.loadImpulseResponse(std::move(impulse), sampleRate, [finished](bool loaded) { *finished = loaded; });
+
+        for (int waited = 0; ! finished->has_value() && waited < 10000; waited += 10)
+            juce::MessageManager::getInstance()->runDispatchLoopUntil(10);
+
+        return finished->value_or(false);
+    }
+
+    template <typename SampleType>
+    bool runBenchmark(const BenchmarkConfig& config, BenchmarkResult& result)
+    {
+        AudioPluginProcessor processor;
+
+        auto layout = processor.getBusesLayout();
+        for (auto& bus : layout.inputBuses)
+            bus = channelSetFor(config.numChannels);
+        for (auto& bus : layout.outputBuses)
+            bus = channelSetFor(config.numChannels);
+
+        if (! processor.setBusesLayout(layout))
+            return false;
+
+        processor.setProcessingPrecision(config.doublePrecision ? juce::AudioProcessor::doublePrecision
+                                                                : juce::AudioProcessor::singlePrecision);
+        processor.setNonRealtime(config.offline);
+        processor.setNumWorkerThreads(config.numWorkerThreads);
+        processor.setRateAndBufferSizeDetails(config.sampleRate, config.blockSize);
+        processor.prepareToPlay(config.sampleRate, config.blockSize);
+
+        // Allocate everything up front so only processBlock is inside the timed region
+        juce::AudioBuffer<SampleType> buffer(config.numChannels, config.blockSize);
+        juce::MidiBuffer midi;
+        juce::Random random(0x5eed);
+
+        if (config.impulseSamples > 0)
+        {
+            if (! loadImpulseResponseAndWait(processor, makeImpulseResponse(random, config.impulseSamples), config.sampleRate))
+                return false;
+
+            juce::Thread::sleep(250); // partitioned in the background; let the first engine swap land
+        }
+
+        auto refill = [&]
+        {
+            for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+            {
+                auto* data = buffer.getWritePointer(ch);
+                for (int i = 0; i < buffer.getNumSamples(); ++i)
+                    data[i] = static_cast<SampleType>(random.nextFloat() * 2.0f - 1.0f) * SampleType(0.5);
+            }
+        };
+
+        auto* gainParam = processor.getValueTreeState().getParameter(ParameterTable::get(ParameterTable::Id::gain).id);
+        const auto numBlocks = static_cast<size_t>((config.totalSamples + config.blockSize - 1) / config.blockSize);
+        std::vector<double> blockMicros(numBlocks);
+
+        // Warm up caches and let the gain ramp settle before measuring
+        for (int i = 0; i < 64; ++i)
+        {
+            refill();
+            processor.processBlock(buffer, midi);
+        }
+
+        double totalNanos = 0.0;
+
+        for (size_t blockIndex = 0; blockIndex < numBlocks; ++blockIndex)
+        {
+            refill();
+
+            if (config.automate && gainParam != nullptr)
+                gainParam->setValueNotifyingHost(random.nextFloat());
+
+            auto start = std::chrono::steady_clock::now();
+            processor.processBlock(buffer, midi);
+            auto end = std::chrono::steady_clock::now();
+
+            auto nanos = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+            totalNanos += nanos;
+            blockMicros[blockIndex] = nanos * 1.0e-3;
+        }
+
+        processor.releaseResources();
+
+        const auto samplesProcessed = static_cast<double>(numBlocks) * config.blockSize;
+        const auto audioNanos = samplesProcessed / config.sampleRate * 1.0e9;
+
+        std::sort(blockMicros.begin(), blockMicros.end());
+
+        result.nsPerSample = totalNanos / samplesProcessed;
+        result.p50Micros = percentile(blockMicros, 0.50);
+        result.p99Micros = percentile(blockMicros, 0.99);
+        result.maxMicros = blockMicros.back();
+        result.realtimeCpuPercent = 100.0 * totalNanos / audioNanos;
+
+        if (const auto* pool = processor.getWorkerPool())
+            result.workerStats = pool->getStats();
+
+        return true;
+    }
+
+    //==============================================================================
+    template <typename SampleType>
+    double timeRampKernel(GainKernels::InstructionSet instructionSet, int blockSize)
+    {
+        auto kernel = GainKernels::getRampKernel<SampleType>(instructionSet);
+        juce::AudioBuffer<SampleType> buffer(2, blockSize);
+
+        for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+            juce::FloatVectorOperations::fill(buffer.getWritePointer(ch), SampleType(0.5), blockSize);
+
+        const int iterations = juce::jmax(1000, (1 << 24) / blockSize);
+        auto start = std::chrono::steady_clock::now();
+
+        for (int i = 0; i < iterations; ++i)
+        {
+            // A ramp that ends where it started keeps the data from drifting to denormals/inf
+            const auto direction = (i & 1) != 0 ? SampleType(-1) : SampleType(1);
+            kernel(buffer.getWritePointer(0), buffer.getWritePointer(1), blockSize,
+                   SampleType(1), direction * SampleType(1.0e-7));
+        }
+
+        auto end = std::chrono::steady_clock::now();
+        return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count())
+             / iterations;
+    }
+
+    /** ns per call of a DspCore variant's exp2 ramp plus scan over one channel. */
+    template <typename SampleType>
+    double timeDspCoreKernels(DspCore::Variant variant, int blockSize)
+    {
+        const auto& kernels = DspCore::getKernels<SampleType>(variant);
+        std::vector<SampleType> data(static_cast<size_t>(blockSize));
+
+        const int iterations = juce::jmax(1000, (1 << 22) / blockSize);
+        SampleType peak(0);
+        auto needsRepair = false;
+        auto start = std::chrono::steady_clock::now();
+
+        for (int i = 0; i < iterations; ++i)
+        {
+            kernels.fillExp2Ramp(data.data(), blockSize, SampleType(-3), SampleType(1.0e-4));
+            needsRepair = kernels.scanForRepair(data.data(), data.size(), peak) || needsRepair;
+        }
+
+        auto end = std::chrono::steady_clock::now();
+        jassert(! needsRepair);
+        juce::ignoreUnused(needsRepair);
+
+        return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count())
+             / iterations;
+    }
+
+    void runKernelBenchmarks(const juce::Array<int>& blockSizes)
+    {
+        using GainKernels::InstructionSet;
+
+        std::printf("%-7s %-8s %6s %12s %8s\n", "prec", "isa", "block", "ns/block", "speedup");
+
+        for (auto blockSize : blockSizes)
+        {
+            const auto scalarFloat = timeRampKernel<float>(InstructionSet::scalar, blockSize);
+            const auto scalarDouble = timeRampKernel<double>(InstructionSet::scalar, blockSize);
+
+            for (auto isa : { InstructionSet::scalar, InstructionSet::sse2, InstructionSet::avx2,
+                              InstructionSet::avx512, InstructionSet::neon })
+            {
+                if (! GainKernels::isSupported(isa))
+                    continue;
+
+                auto floatNanos = timeRampKernel<float>(isa, blockSize);
+                auto doubleNanos = timeRampKernel<double>(isa, blockSize);
+
+                std::printf("%-7s %-8s %6d %12.1f %7.2fx\n", "float", GainKernels::getName(isa),
+                            blockSize, floatNanos, scalarFloat / floatNanos);
+                std::printf("%-7s %-8s %6d %12.1f %7.2fx\n", "double", GainKernels::getName(isa),
+                            blockSize, doubleNanos, scalarDouble / doubleNanos);
+            }
+        }
+
+        // DspCore: the exp2 ramp and input scan, per variant built with PLUGIN_CPU_VARIANTS
+        std::printf("\n%-7s %-12s %6s %12s %8s\n", "prec", "variant", "block", "ns/block", "speedup");
+
+        for (auto blockSize : blockSizes)
+        {
+            const auto baselineFloat = timeDspCoreKernels<float>(DspCore::Variant::baseline, blockSize);
+            const auto baselineDouble = timeDspCoreKernels<double>(DspCore::Variant::baseline, blockSize);
+
+            for (auto variant : { DspCore::Variant::baseline, DspCore::Variant::avx2,
+                                  DspCore::Variant::avx512, DspCore::Variant::appleSilicon })
+            {
+                if (! DspCore::isSupported(variant))
+                    continue;
+
+                auto floatNanos = timeDspCoreKernels<float>(variant, blockSize);
+                auto doubleNanos = timeDspCoreKernels<double>(variant, blockSize);
+
+                std::printf("%-7s %-12s %6d %12.1f %7.2fx\n", "float", DspCore::getName(variant),
+                            blockSize, floatNanos, baselineFloat / floatNanos);
+                std::printf("%-7s %-12s %6d %12.1f %7.2fx\n", "double", DspCore::getName(variant),
+                            blockSize, doubleNanos, baselineDouble / doubleNanos);
+            }
+        }
+    }
+
+    //==============================================================================
+    template <typename Function>
+    double timeNanosPerCall(int iterations, Function&& function)
+    {
+        auto start = std::chrono::steady_clock::now();
+
+        for (int i = 0; i < iterations; ++i)
+            function();
+
+        auto end = std::chrono::steady_clock::now();
+        return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count())
+             / iterations;
+    }
+
+    //==============================================================================
+    /**
+     * One FastMath function against its std counterpart: the maximum error
+     * (relative or absolute) over a dense sweep of [low, high] against a
+     * long double reference, and ns per value for both over a block of inputs.
+     */
+    template <typename SampleType, typename Fast, typename Standard, typename Reference>
+    void benchmarkApproximation(const char* name, SampleType low, SampleType high, bool relativeError,
+                                Fast fast, Standard standard, Reference reference)
+    {
+        constexpr int numSweepPoints = 1 << 20;
+        constexpr int blockSize = 4096;
+        constexpr int iterations = 2000;
+
+        double maxError = 0.0;
+
+        for (int i = 0; i <= numSweepPoints; ++i)
+        {
+            const auto x = static_cast<SampleType>(low + (high - low) * static_cast<SampleType>(i) / numSweepPoints);
+            const auto exact = reference(static_cast<long double>(x));
+            auto error = std::abs(static_cast<long double>(fast(x)) - exact);
+
+            if (relativeError && exact != 0.0L)
+                error /= std::abs(exact);
+
+            maxError = std::max(maxError, static_cast<double>(error));
+        }
+
+        std::vector<SampleType> input(blockSize), output(blockSize);
+
+        for (size_t i = 0; i < input.size(); ++i)
+            input[i] = static_cast<SampleType>(low + (high - low) * static_cast<SampleType>(i) / blockSize);
+
+        const auto fastNanos = timeNanosPerCall(iterations, [&]
+        {
+            for (size_t i = 0; i < input.size(); ++i)
+                output[i] = fast(input[i]);
+        }) / blockSize;
+
+        const auto standardNanos = timeNanosPerCall(iterations, [&]
+        {
+            for (size_t i = 0; i < input.size(); ++i)
+                output[i] = standard(input[i]);
+        }) / blockSize;
+
+        std::printf("%-7s %-16s %10.2f %10.2f %7.2fx %10.2e %s\n",
+                    std::is_same_v<SampleType, float> ? "float" : "double", name,
+                    fastNanos, standardNanos, standardNanos / fastNanos,
+                    maxError, relativeError ? "rel" : "abs");
+    }
+
+    template <typename SampleType>
+    void benchmarkApproximations()
+    {
+        const auto lowestExponent = static_cast<SampleType>(std::numeric_limits<SampleType>::min_exponent - 1);
+
+        benchmarkApproximation<SampleType>("exp2", lowestExponent, SampleType(16), true,
+                                           [] (SampleType x) { return FastMath::exp2(x); },
+                                           [] (SampleType x) { return std::exp2(x); },
+                                           [] (long double x) { return std::exp2(x); });
+
+        // The gain parameter's range, and the default silence threshold
+        benchmarkApproximation<SampleType>("decibelsToGain", SampleType(-99), SampleType(24), true,
+                                           [] (SampleType x) { return FastMath::decibelsToGain(x); },
+                                           [] (SampleType x) { return juce::Decibels::decibelsToGain(x); },
+                                           [] (long double x) { return std::pow(10.0L, x / 20.0L); });
+
+        benchmarkApproximation<SampleType>("tanh", SampleType(-12), SampleType(12), false,
+                                           [] (SampleType x) { return FastMath::tanh(x); },
+                                           [] (SampleType x) { return std::tanh(x); },
+                                           [] (long double x) { return std::tanh(x); });
+
+        // No std equivalent: timed against the tanh it would replace as a saturator
+        benchmarkApproximation<SampleType>("softClip/tanh", SampleType(-2), SampleType(2), false,
+                                           [] (SampleType x) { return FastMath::softClip(x); },
+                                           [] (SampleType x) { return std::tanh(x); },
+                                           [] (long double x)
+                                           {
+                                               const auto clipped = std::clamp(x, -1.0L, 1.0L);
+                                               return clipped * (1.5L - 0.5L * clipped * clipped);
+                                           });
+    }
+
+    void runMathBenchmarks()
+    {
+        std::printf("%-7s %-16s %10s %10s %8s %10s\n", "prec", "function", "fast ns", "std ns", "speedup", "max error");
+        benchmarkApproximations<float>();
+        benchmarkApproximations<double>();
+    }
+
+    //==============================================================================
+    void runStateBenchmarks()
+    {
+        AudioPluginProcessor processor;
+        const auto numParameters = juce::jmax(1, processor.getParameters().size());
+        constexpr int iterations = 20000;
+
+        juce::MemoryBlock binaryState, xmlState;
+        processor.getStateInformation(binaryState);
+
+        if (auto xml = processor.getValueTreeState().copyState().createXml())
+            juce::AudioProcessor::copyXmlToBinary(*xml, xmlState);
+
+        auto save = timeNanosPerCall(iterations, [&] { processor.getStateInformation(binaryState); });
+        auto restore = timeNanosPerCall(iterations, [&] { processor.setStateInformation(binaryState.getData(),
+                                                                                        static_cast<int>(binaryState.getSize())); });
+        auto restoreXml = timeNanosPerCall(iterations, [&] { processor.setStateInformation(xmlState.getData(),
+                                                                                           static_cast<int>(xmlState.getSize())); });
+        auto saveXml = timeNanosPerCall(iterations, [&]
+        {
+            juce::MemoryBlock block;
+            if (auto xml = processor.getValueTreeState().copyState().createXml())
+                juce::AudioProcessor::copyXmlToBinary(*xml, block);
+        });
+
+        std::printf("%-16s %10s %12s %8s\n", "operation", "ns/call", "ns/param", "bytes");
+        std::printf("%-16s %10.1f %12.1f %8d\n", "save (binary)", save, save / numParameters, static_cast<int>(binaryState.getSize()));
+        std::printf("%-16s %10.1f %12.1f %8d\n", "restore (binary)", restore, restore / numParameters, static_cast<int>(binaryState.getSize()));
+        std::printf("%-16s %10.1f %12.1f %8d\n", "save (xml)", saveXml, saveXml / numParameters, static_cast<int>(xmlState.getSize()));
+        std::printf("%-16s %10.1f %12.1f %8d\n", "restore (xml)", restoreXml, restoreXml / numParameters, static_cast<int>(xmlState.getSize()));
+
+        // Program switching from a memory-mapped bank of random programs
+        constexpr int numPrograms = 128;
+        juce::Array<PresetBank::Program> programs;
+        juce::Random random(0x5eed);
+
+        for (int program = 0; program < numPrograms; ++program)
+        {
+            for (auto* parameter : processor.getParameters())
+                parameter->setValueNotifyingHost(random.nextFloat());
+
+            programs.add(processor.captureProgram("Program " + juce::String(program + 1)));
+        }
+
+        const juce::TemporaryFile bankFile(".bank");
+
+        if (! PresetBank::write(bankFile.getFile(), programs))
+        {
+            std::printf("couldn't write %s\n", bankFile.getFile().getFullPathName().toRawUTF8());
+            return;
+        }
+
+        const auto bankBytes = static_cast<int>(bankFile.getFile().getSize());
+        auto openBank = timeNanosPerCall(200, [&] { processor.loadPresetBank(bankFile.getFile()); });
+
+        int nextProgram = 0;
+        auto switchProgram = timeNanosPerCall(iterations, [&]
+        {
+            processor.setCurrentProgram(nextProgram);
+            nextProgram = (nextProgram + 1) % numPrograms;
+        });
+
+        std::printf("%-16s %10.1f %12.1f %8d\n", "open bank", openBank, openBank / numPrograms, bankBytes);
+        std::printf("%-16s %10.1f %12.1f %8d\n", "switch program", switchProgram, switchProgram / numParameters,
+                    static_cast<int>(programs.getReference(0).state.getSize()));
+    }
+
+    //==============================================================================
+    struct StressStats
+    {
+        juce::int64 numBlocks = 0;
+        juce::int64 numSamples = 0;
+        int numFailures = 0;
+    };
+
+    template <typename SampleType>
+    bool isFinite(const juce::AudioBuffer<SampleType>& buffer) noexcept
+    {
+        for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+            for (int i = 0; i < buffer.getNumSamples(); ++i)
+                if (! std::isfinite(buffer.getSample(ch, i)))
+                    return false;
+
+        return true;
+    }
+
+    template <typename SampleType>
+    void stressBlocks(AudioPluginProcessor& processor, juce::Random& random,
+                      int maxBlockSize, int numChannels, int numBlocks, StressStats& stats)
+    {
+        // Hosts with variable buffers can exceed the size they promised
+        constexpr int maxOverrun = 4;
+        juce::AudioBuffer<SampleType> buffer(numChannels, maxBlockSize * maxOverrun);
+        juce::MidiBuffer midi;
+        const auto& parameters = processor.getParameters();
+
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            // Mostly up to the prepared size (including empty blocks), with
+            // runs of tiny blocks and some larger than promised
+            const auto shape = random.nextInt(8);
+            const auto numSamples = shape == 0 ? random.nextInt(maxBlockSize * maxOverrun + 1)
+                                  : shape == 1 ? 1 + random.nextInt(4)
+                                               : random.nextInt(maxBlockSize + 1);
+            buffer.setSize(numChannels, numSamples, false, false, true);
+
+            if (random.nextInt(8) == 0)
+            {
+                buffer.clear();
+            }
+            else
+            {
+                for (int ch = 0; ch < numChannels; ++ch)
+                    for (int i = 0; i < numSamples; ++i)
+                        buffer.setSample(ch, i, static_cast<SampleType>(random.nextFloat() * 2.0f - 1.0f));
+            }
+
+            // Host-side changes between blocks, as a DAW's automation thread would make them
+            for (int n = random.nextInt(4); --n >= 0;)
+                if (auto* parameter = parameters[random.nextInt(parameters.size())]; parameter->isAutomatable())
+                    parameter->setValueNotifyingHost(random.nextFloat());
+
+            if (random.nextInt(16) == 0)
+                processor.setAutomationMode(random.nextBool() ? AudioPluginProcessor::AutomationMode::perBlock
+                                                              : AudioPluginProcessor::AutomationMode::sampleAccurate);
+
+            if (random.nextInt(16) == 0)
+                processor.getLevelMeters().setEnabled(random.nextBool());
+
+            // CCs at random positions, mapped or not, and now and then a learn
+            midi.clear();
+
+            for (int n = random.nextInt(8); --n >= 0;)
+                midi.addEvent(juce::MidiMessage::controllerEvent(1 + random.nextInt(16), random.nextInt(128), random.nextInt(128)),
+                              random.nextInt(juce::jmax(1, numSamples)));
+
+            if (random.nextInt(64) == 0)
+                processor.getMidiControlMap().startLearning(random.nextInt(parameters.size()));
+
+            processor.processBlock(buffer, midi);
+
+            if (! isFinite(buffer))
+            {
+                std::printf("  non-finite output: block %d, %d samples, %d channels\n", block, numSamples, numChannels);
+                ++stats.numFailures;
+            }
+
+            ++stats.numBlocks;
+            stats.numSamples += numSamples;
+        }
+    }
+
+    int runStressTest(int numRounds, int seed)
+    {
+        static constexpr double sampleRates[] = { 44100.0, 48000.0, 88200.0, 96000.0, 192000.0 };
+        static constexpr int channelCounts[] = { 1, 2, 6, 8 };
+
+        juce::Random random(seed);
+        AudioPluginProcessor processor;
+        auto& apvts = processor.getValueTreeState();
+        StressStats stats;
+
+        // A few fixed assignments; the blocks also send unmapped CCs
+        auto& midiMap = processor.getMidiControlMap();
+        midiMap.setMapping(MidiControlMap::omni, 7, ParameterTable::indexOf(ParameterTable::Id::gain));
+        midiMap.setMapping(1, 74, ParameterTable::indexOf(ParameterTable::Id::limiterCeiling));
+
+        for (int round = 0; round < numRounds; ++round)
+        {
+            const auto sampleRate = sampleRates[random.nextInt(juce::numElementsInArray(sampleRates))];
+            const auto maxBlockSize = 1 + random.nextInt(4096);
+            const auto numChannels = channelCounts[random.nextInt(juce::numElementsInArray(channelCounts))];
+            const auto isDouble = random.nextBool();
+
+            auto layout = processor.getBusesLayout();
+            for (auto& bus : layout.inputBuses)
+                bus = channelSetFor(numChannels);
+            for (auto& bus : layout.outputBuses)
+                bus = channelSetFor(numChannels);
+
+            if (! processor.setBusesLayout(layout))
+                continue;
+
+            // Settings that are only picked up by prepareToPlay
+            for (const auto& descriptor : ParameterTable::descriptors)
+                if (descriptor.changesLatency)
+                    apvts.getParameter(descriptor.id)->setValueNotifyingHost(random.nextFloat());
+
+            // Single-threaded, or with a few workers sharing the convolution
+            processor.setNumWorkerThreads(random.nextInt(3));
+
+            // Convolution bypassed or running a synthetic IR of random length
+            if (random.nextBool())
+                loadImpulseResponseAndWait(processor, makeImpulseResponse(random, 16 + random.nextInt(16384)), sampleRate);
+            else
+                processor.clearImpulseResponse();
+
+            processor.releaseResources();
+            processor.setProcessingPrecision(isDouble ? juce::AudioProcessor::doublePrecision
+                                                      : juce::AudioProcessor::singlePrecision);
+            processor.setNonRealtime(random.nextBool());
+            processor.setRateAndBufferSizeDetails(sampleRate, maxBlockSize);
+            processor.prepareToPlay(sampleRate, maxBlockSize);
+
+            const auto numBlocks = 64 + random.nextInt(192);
+
+            if (isDouble)
+                stressBlocks<double>(processor, random, maxBlockSize, numChannels, numBlocks, stats);
+            else
+                stressBlocks<float>(processor, random, maxBlockSize, numChannels, numBlocks, stats);
+        }
+
+        processor.releaseResources();
+
+        std::printf("stress: %d rounds, %lld blocks, %lld samples, seed %d, realtime checks %s\n",
+                    numRounds, static_cast<long long>(stats.numBlocks), static_cast<long long>(stats.numSamples),
+                    seed, RealtimeGuard::isEnabled() ? "on" : "off (configure with -DPLUGIN_REALTIME_CHECKS=ON)");
+
+        if (stats.numFailures > 0)
+        {
+            std::printf("stress: FAILED (%d blocks with non-finite output)\n", stats.numFailures);
+            return 1;
+        }
+
+        std::printf("stress: passed\n");
+        return 0;
+    }
+
+    //==============================================================================
+    void printStageTimes(const char* stage, std::vector<double>& micros)
+    {
+        std::sort(micros.begin(), micros.end());
+
+        double total = 0.0;
+        for (auto value : micros)
+            total += value;
+
+        std::printf("%-14s %10.1f %10.1f %10.1f %10.1f\n", stage,
+                    total / static_cast<double>(juce::jmax<size_t>(1, micros.size())),
+                    percentile(micros, 0.50), percentile(micros, 0.99), micros.empty() ? 0.0 : micros.back());
+    }
+
+    void runStartupBenchmarks(int numInstances)
+    {
+        using Clock = std::chrono::steady_clock;
+        auto microsBetween = [](Clock::time_point start, Clock::time_point end)
+        {
+            return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()) * 1.0e-3;
+        };
+
+        std::vector<double> construct, scan, firstPrepare, destroy;
+        double checksum = 0.0;
+
+        // Sequential, like a host opening a large session
+        for (int i = 0; i < numInstances; ++i)
+        {
+            const auto t0 = Clock::now();
+            auto processor = std::make_unique<AudioPluginProcessor>();
+            const auto t1 = Clock::now();
+
+            // Roughly what a scanner asks for before discarding the instance
+            checksum += processor->getName().length() + processor->getTailLengthSeconds()
+                      + processor->getBusCount(true) + processor->getBusCount(false)
+                      + (processor->acceptsMidi() ? 1 : 0) + processor->getNumPrograms();
+
+            for (auto* parameter : processor->getParameters())
+                checksum += parameter->getName(64).length() + parameter->getDefaultValue();
+
+            const auto t2 = Clock::now();
+            processor->setRateAndBufferSizeDetails(48000.0, 512);
+            processor->prepareToPlay(48000.0, 512);
+            const auto t3 = Clock::now();
+            processor->releaseResources();
+            processor.reset();
+            const auto t4 = Clock::now();
+
+            construct.push_back(microsBetween(t0, t1));
+            scan.push_back(microsBetween(t1, t2));
+            firstPrepare.push_back(microsBetween(t2, t3));
+            destroy.push_back(microsBetween(t3, t4));
+        }
+
+        std::printf("%-14s %10s %10s %10s %10s\n", "stage", "mean us", "p50 us", "p99 us", "max us");
+        printStageTimes("construct", construct);
+        printStageTimes("scan queries", scan);
+        printStageTimes("first prepare", firstPrepare);
+        printStageTimes("destroy", destroy);
+        std::printf("%d instances (checksum %.0f)\n", numInstances, checksum);
+    }
+
+    //==============================================================================
+    enum class PathologicalInput
+    {
+        noise,        // reference
+        decayingTail, // noise decaying past the smallest normal value
+        subnormal,    // every sample subnormal
+        nanEveryBlock,
+        infEveryBlock,
+        nanOnce       // one NaN, then clean noise: the chain must recover
+    };
+
+    const char* getName(PathologicalInput input) noexcept
+    {
+        switch (input)
+        {
+            case PathologicalInput::noise:         return "noise";
+            case PathologicalInput::decayingTail:  return "decaying tail";
+            case PathologicalInput::subnormal:     return "subnormal";
+            case PathologicalInput::nanEveryBlock: return "NaN per block";
+            case PathologicalInput::infEveryBlock: return "Inf per block";
+            case PathologicalInput::nanOnce:       return "NaN once";
+        }
+
+        return "";
+    }
+
+    template <typename SampleType>
+    void fillPathological(juce::AudioBuffer<SampleType>& buffer, PathologicalInput input, juce::Random& random,
+                          juce::int64 blockIndex, SampleType& decay)
+    {
+        constexpr auto tiny = std::numeric_limits<SampleType>::denorm_min() * SampleType(64);
+
+        for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+        {
+            auto* data = buffer.getWritePointer(ch);
+
+            for (int i = 0; i < buffer.getNumSamples(); ++i)
+            {
+                const auto noise = static_cast<SampleType>(random.nextFloat() * 2.0f - 1.0f);
+                data[i] = input == PathologicalInput::subnormal    ? noise * tiny
+                        : input == PathologicalInput::decayingTail ? noise * decay
+                                                                   : noise * SampleType(0.5);
+            }
+        }
+
+        // About -1 dB per block, restarting once well below the subnormal range
+        decay = decay < tiny ? SampleType(1) : decay * SampleType(0.9);
+
+        const auto position = random.nextInt(buffer.getNumSamples());
+
+        if (input == PathologicalInput::nanEveryBlock || (input == PathologicalInput::nanOnce && blockIndex == 0))
+            buffer.setSample(0, position, std::numeric_limits<SampleType>::quiet_NaN());
+        else if (input == PathologicalInput::infEveryBlock)
+            buffer.setSample(0, position, std::numeric_limits<SampleType>::infinity());
+    }
+
+    template <typename SampleType>
+    int runPathologicalBenchmark(int blockSize, PathologicalInput input, double referenceNsPerSample, double& nsPerSample)
+    {
+        constexpr double sampleRate = 48000.0;
+        constexpr juce::int64 totalSamples = 1 << 20;
+
+        AudioPluginProcessor processor;
+        auto& apvts = processor.getValueTreeState();
+
+        // Every stage with recursive state: limiter, oversampling filters, convolution
+        auto setChoice = [&apvts](ParameterTable::Id id, int index)
+        {
+            auto* parameter = apvts.getParameter(ParameterTable::get(id).id);
+            parameter->setValueNotifyingHost(parameter->convertTo0to1(static_cast<float>(index)));
+        };
+
+        setChoice(ParameterTable::Id::oversampling, 1);
+        setChoice(ParameterTable::Id::limiterLookahead, 3);
+
+        processor.setProcessingPrecision(std::is_same_v<SampleType, double> ? juce::AudioProcessor::doublePrecision
+                                                                            : juce::AudioProcessor::singlePrecision);
+        processor.setRateAndBufferSizeDetails(sampleRate, blockSize);
+        processor.prepareToPlay(sampleRate, blockSize);
+
+        juce::Random random(0x5eed);
+        loadImpulseResponseAndWait(processor, makeImpulseResponse(random, 4096), sampleRate);
+        juce::Thread::sleep(250); // let the partitioned IR land
+
+        juce::AudioBuffer<SampleType> buffer(2, blockSize);
+        juce::MidiBuffer midi;
+        auto decay = SampleType(1);
+        const auto numBlocks = (totalSamples + blockSize - 1) / blockSize;
+        int numNonFinite = 0;
+        double totalNanos = 0.0;
+
+        for (juce::int64 block = 0; block < numBlocks; ++block)
+        {
+            fillPathological(buffer, input, random, block, decay);
+
+            const auto start = std::chrono::steady_clock::now();
+            processor.processBlock(buffer, midi);
+            const auto end = std::chrono::steady_clock::now();
+
+            totalNanos += static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+            numNonFinite += isFinite(buffer) ? 0 : 1;
+        }
+
+        processor.releaseResources();
+        nsPerSample = totalNanos / static_cast<double>(numBlocks * blockSize);
+
+        std::printf("%-7s %6d %-14s %10.3f %8.2fx %9u %9d\n", std::is_same_v<SampleType, double> ? "double" : "float",
+                    blockSize, getName(input), nsPerSample,
+                    referenceNsPerSample > 0.0 ? nsPerSample / referenceNsPerSample : 1.0,
+                    static_cast<unsigned int>(processor.getNumRepairedInputBlocks()), numNonFinite);
+
+        return numNonFinite;
+    }
+
+    int runPathologicalBenchmarks(const juce::Array<int>& blockSizes)
+    {
+        std::printf("%-7s %6s %-14s %10s %9s %9s %9s\n", "prec", "block", "input", "ns/sample", "vs noise", "repaired", "non-fin");
+        int numNonFinite = 0;
+
+        auto runAll = [&](auto sampleTypeTag, int blockSize)
+        {
+            using SampleType = decltype(sampleTypeTag);
+            double reference = 0.0, nsPerSample = 0.0;
+
+            for (auto input : { PathologicalInput::noise, PathologicalInput::decayingTail, PathologicalInput::subnormal,
+                                PathologicalInput::nanEveryBlock, PathologicalInput::infEveryBlock, PathologicalInput::nanOnce })
+            {
+                numNonFinite += runPathologicalBenchmark<SampleType>(blockSize, input, reference, nsPerSample);
+
+                if (input == PathologicalInput::noise)
+                    reference = nsPerSample;
+            }
+        };
+
+        for (auto blockSize : blockSizes)
+        {
+            runAll(float {}, blockSize);
+            runAll(double {}, blockSize);
+        }
+
+        if (numNonFinite > 0)
+        {
+            std::printf("pathological: FAILED (%d blocks with non-finite output)\n", numNonFinite);
+            return 1;
+        }
+
+        std::printf("pathological: passed\n");
+        return 0;
+    }
+
+    //==============================================================================
+    struct RegressionCase
+    {
+        juce::String name;
+        juce::String unit;
+        double value = 0.0; // lower is better
+    };
+
+    /** Median of a few runs, so one descheduled run doesn't decide the result. */
+    template <typename Function>
+    double medianOfRuns(Function&& measure)
+    {
+        constexpr int numRuns = 5;
+        std::vector<double> values;
+
+        for (int run = 0; run < numRuns; ++run)
+            values.push_back(measure());
+
+        std::sort(values.begin(), values.end());
+        return values[values.size() / 2];
+    }
+
+    std::vector<RegressionCase> measureRegressionCases()
+    {
+        std::vector<RegressionCase> cases;
+
+        // processBlock: small, typical and large blocks; stereo and a wide layout
+        struct ProcessCase { int blockSize; int numChannels; bool doublePrecision; bool automate; };
+        static constexpr ProcessCase processCases[] = {
+            { 64, 2, false, false }, { 512, 2, false, false }, { 2048, 2, false, false },
+            { 512, 8, false, false }, { 512, 2, true, false }, { 512, 2, false, true }
+        };
+
+        for (const auto& processCase : processCases)
+        {
+            BenchmarkConfig config;
+            config.sampleRate = 48000.0;
+            config.blockSize = processCase.blockSize;
+            config.numChannels = processCase.numChannels;
+            config.doublePrecision = processCase.doublePrecision;
+            config.automate = processCase.automate;
+            config.totalSamples = 1 << 20;
+
+            auto supported = true;
+            const auto nsPerSample = medianOfRuns([&]
+            {
+                BenchmarkResult result;
+                supported = processCase.doublePrecision ? runBenchmark<double>(config, result)
+                                                        : runBenchmark<float>(config, result);
+                return result.nsPerSample;
+            });
+
+            if (supported)
+                cases.push_back({ "process/" + juce::String(processCase.doublePrecision ? "double" : "float")
+                                      + "/" + juce::String(processCase.blockSize) + "x" + juce::String(processCase.numChannels)
+                                      + (processCase.automate ? "/automated" : ""),
+                                  "ns/sample", nsPerSample });
+        }
+
+        // State save/restore in the binary format
+        {
+            AudioPluginProcessor processor;
+            juce::MemoryBlock state;
+            processor.getStateInformation(state);
+
+            cases.push_back({ "state/save", "ns/call", medianOfRuns([&]
+            {
+                return timeNanosPerCall(20000, [&] { processor.getStateInformation(state); });
+            }) });
+
+            cases.push_back({ "state/restore", "ns/call", medianOfRuns([&]
+            {
+                return timeNanosPerCall(20000, [&] { processor.setStateInformation(state.getData(), static_cast<int>(state.getSize())); });
+            }) });
+        }
+
+        // What a host pays per instance it scans
+        cases.push_back({ "instance/construct+destroy", "ns/call", medianOfRuns([]
+        {
+            return timeNanosPerCall(50, [] { AudioPluginProcessor processor; });
+        }) });
+
+        // Editor paint into an image: steady state, and after a resize re-renders the background
+        {
+            AudioPluginProcessor processor;
+            std::unique_ptr<juce::AudioProcessorEditor> editor(processor.createEditor());
+            juce::Image image(juce::Image::ARGB, 420, 300, true);
+            juce::Graphics g(image);
+            editor->paintEntireComponent(g, false);
+
+            cases.push_back({ "editor/paint", "ns/call", medianOfRuns([&]
+            {
+                return timeNanosPerCall(200, [&] { editor->paintEntireComponent(g, false); });
+            }) });
+
+            int width = 400;
+            cases.push_back({ "editor/resize+paint", "ns/call", medianOfRuns([&]
+            {
+                return timeNanosPerCall(50, [&]
+                {
+                    width = width == 400 ? 420 : 400;
+                    editor->setSize(width, 300);
+                    editor->paintEntireComponent(g, false);
+                });
+            }) });
+        }
+
+        return cases;
+    }
+
+    bool writeRegressionBaseline(const juce::File& file, const std::vector<RegressionCase>& cases, double tolerancePercent)
+    {
+        auto* caseObject = new juce::DynamicObject();
+
+        for (const auto& regressionCase : cases)
+        {
+            auto* entry = new juce::DynamicObject();
+            entry->setProperty("value", regressionCase.value);
+            entry->setProperty("unit", regressionCase.unit);
+            caseObject->setProperty(regressionCase.name, juce::var(entry));
+        }
+
+        auto* root = new juce::DynamicObject();
+        root->setProperty("format", 1);
+        root->setProperty("tolerancePercent", tolerancePercent);
+        root->setProperty("machine", juce::SystemStats::getCpuModel() + ", " + juce::SystemStats::getOperatingSystemName());
+        root->setProperty("cases", juce::var(caseObject));
+
+        return file.replaceWithText(juce::JSON::toString(juce::var(root)) + "\n");
+    }
+
+    /** Returned when there is no recorded baseline; CTest reports the gate as skipped. */
+    constexpr int regressionNotRecorded = 77;
+
+    /**
+     * Compares against the baseline: a case fails when it is more than the
+     * tolerance slower. Cases may override the file's tolerancePercent. A case
+     * missing from the baseline fails too, so a new case can't go ungated:
+     * record it with --write-baseline in the same change that adds it. With
+     * no baseline recorded yet there is nothing to compare, and the run says
+     * so rather than passing.
+     */
+    int runRegressionSuite(const juce::File& baselineFile, bool writeBaseline, double toleranceOverride)
+    {
+        if (! writeBaseline && ! baselineFile.existsAsFile())
+        {
+            std::printf("regression: NOT RUN, no baseline recorded at %s (run perf-baseline on this machine)\n",
+                        baselineFile.getFullPathName().toRawUTF8());
+            return regressionNotRecorded;
+        }
+
+        const auto baseline = baselineFile.existsAsFile() ? juce::JSON::parse(baselineFile) : juce::var();
+
+        if (! writeBaseline && ! baseline.isObject())
+        {
+            std::printf("regression: can't read baseline %s\n", baselineFile.getFullPathName().toRawUTF8());
+            return 1;
+        }
+
+        if (! writeBaseline && baseline["cases"].getDynamicObject() == nullptr)
+        {
+            std::printf("regression: NOT RUN, %s records no cases (run perf-baseline on this machine)\n",
+                        baselineFile.getFullPathName().toRawUTF8());
+            return regressionNotRecorded;
+        }
+
+        const auto defaultTolerance = toleranceOverride > 0.0 ? toleranceOverride
+                                    : baseline.hasProperty("tolerancePercent") ? static_cast<double>(baseline["tolerancePercent"])
+                                                                               : 10.0;
+        const auto cases = measureRegressionCases();
+
+        if (writeBaseline)
+        {
+            if (! writeRegressionBaseline(baselineFile, cases, defaultTolerance))
+            {
+                std::printf("regression: couldn't write %s\n", baselineFile.getFullPathName().toRawUTF8());
+                return 1;
+            }
+
+            std::printf("regression: wrote %d cases to %s\n", static_cast<int>(cases.size()),
+                        baselineFile.getFullPathName().toRawUTF8());
+            return 0;
+        }
+
+        std::printf("%-30s %12s %12s %9s %7s  %s\n", "case", "baseline", "current", "change", "limit", "");
+        int numFailures = 0;
+
+        for (const auto& regressionCase : cases)
+        {
+            const auto entry = baseline["cases"][juce::Identifier(regressionCase.name)];
+
+            if (! entry.isObject())
+            {
+                std::printf("%-30s %12s %12.1f %9s %7s  MISSING (%s, not in the baseline)\n", regressionCase.name.toRawUTF8(),
+                            "-", regressionCase.value, "-", "-", regressionCase.unit.toRawUTF8());
+                ++numFailures;
+                continue;
+            }
+
+            const auto reference = static_cast<double>(entry["value"]);
+            const auto tolerance = toleranceOverride <= 0.0 && entry.hasProperty("tolerancePercent")
+                                       ? static_cast<double>(entry["tolerancePercent"])
+                                       : defaultTolerance;
+            const auto changePercent = reference > 0.0 ? 100.0 * (regressionCase.value - reference) / reference : 0.0;
+            const auto failed = changePercent > tolerance;
+            numFailures += failed ? 1 : 0;
+
+            std::printf("%-30s %12.1f %12.1f %+8.1f%% %6.1f%%  %s\n", regressionCase.name.toRawUTF8(), reference,
+                        regressionCase.value, changePercent, tolerance, failed ? "SLOWER" : "ok");
+        }
+
+        if (numFailures > 0)
+        {
+            std::printf("regression: FAILED (%d of %d cases slower than the baseline allows or missing from it)\n",
+                        numFailures, static_cast<int>(cases.size()));
+            return 1;
+        }
+
+        std::printf("regression: passed\n");
+        return 0;
+    }
+
+    void printUsage()
+    {
+        std::printf("Usage: benchmark [--sample-rates 44100,48000,96000] [--block-sizes 32,...,4096]\n"
+                    "                 [--channels 1,2] [--samples N] [--precision float|double|both]\n"
+                    "                 [--automate] [--offline] [--ir SAMPLES] [--threads N]\n"
+                    "       benchmark --kernels [--block-sizes 512]\n"
+                    "       benchmark --math\n"
+                    "       benchmark --state\n"
+                    "       benchmark --stress [--rounds 64] [--seed 1]\n"
+                    "       benchmark --startup [--instances 200]\n"
+                    "       benchmark --pathological [--block-sizes 512]\n"
+                    "       benchmark --regression FILE [--tolerance PERCENT] [--write-baseline]\n");
+    }
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList args(argc, argv);
+
+    if (args.containsOption("--help|-h"))
+    {
+        printUsage();
+        return 0;
+    }
+
+    if (args.containsOption("--state"))
+    {
+        runStateBenchmarks();
+        return 0;
+    }
+
+    if (args.containsOption("--math"))
+    {
+        runMathBenchmarks();
+        return 0;
+    }
+
+    if (args.containsOption("--startup"))
+    {
+        const auto numInstances = args.containsOption("--instances") ? args.getValueForOption("--instances").getIntValue() : 200;
+        runStartupBenchmarks(juce::jmax(1, numInstances));
+        return 0;
+    }
+
+    if (args.containsOption("--regression"))
+    {
+        const auto tolerance = args.containsOption("--tolerance") ? args.getValueForOption("--tolerance").getDoubleValue() : 0.0;
+        return runRegressionSuite(args.getFileForOption("--regression"), args.containsOption("--write-baseline"), tolerance);
+    }
+
+    if (args.containsOption("--stress"))
+    {
+        const auto numRounds = args.containsOption("--rounds") ? args.getValueForOption("--rounds").getIntValue() : 64;
+        const auto seed = args.containsOption("--seed") ? args.getValueForOption("--seed").getIntValue() : 1;
+        return runStressTest(juce::jmax(1, numRounds), seed);
+    }
+
+    auto sampleRates = parseIntList(args.containsOption("--sample-rates")
+                                        ? args.getValueForOption("--sample-rates")
+                                        : juce::String("44100,48000,96000"));
+    auto blockSizes = parseIntList(args.containsOption("--block-sizes")
+                                       ? args.getValueForOption("--block-sizes")
+                                       : juce::String("32,64,128,256,512,1024,2048,4096"));
+
+    if (args.containsOption("--kernels"))
+    {
+        runKernelBenchmarks(args.containsOption("--block-sizes") ? blockSizes : juce::Array<int> { 512 });
+        return 0;
+    }
+
+    if (args.containsOption("--pathological"))
+        return runPathologicalBenchmarks(args.containsOption("--block-sizes") ? blockSizes : juce::Array<int> { 512 });
+    auto channelCounts = parseIntList(args.containsOption("--channels")
+                                          ? args.getValueForOption("--channels")
+                                          : juce::String("1,2"));
+    auto precision = args.containsOption("--precision") ? args.getValueForOption("--precision")
+                                                         : juce::String("float");
+
+    BenchmarkConfig base;
+    base.automate = args.containsOption("--automate");
+    base.offline = args.containsOption("--offline");
+
+    if (args.containsOption("--ir"))
+        base.impulseSamples = juce::jmax(0, args.getValueForOption("--ir").getIntValue());
+
+    if (args.containsOption("--threads"))
+        base.numWorkerThreads = juce::jmax(0, args.getValueForOption("--threads").getIntValue());
+
+    if (args.containsOption("--samples"))
+        base.totalSamples = std::max<juce::int64>(1, args.getValueForOption("--samples").getLargeIntValue());
+
+    juce::Array<bool> precisions;
+    if (precision == "float" || precision == "both")
+        precisions.add(false);
+    if (precision == "double" || precision == "both")
+        precisions.add(true);
+
+    if (precisions.isEmpty())
+    {
+        printUsage();
+        return 1;
+    }
+
+    std::printf("%-7s %8s %6s %3s %10s %10s %10s %10s %8s\n",
+                "prec", "rate", "block", "ch", "ns/sample", "p50 us", "p99 us", "max us", "cpu %");
+
+    for (auto isDouble : precisions)
+    {
+        for (auto sampleRate : sampleRates)
+        {
+            for (auto blockSize : blockSizes)
+            {
+                for (auto numChannels : channelCounts)
+                {
+                    auto config = base;
+                    config.sampleRate = static_cast<double>(sampleRate);
+                    config.blockSize = blockSize;
+                    config.numChannels = numChannels;
+                    config.doublePrecision = isDouble;
+
+                    BenchmarkResult result;
+                    auto ok = isDouble ? runBenchmark<double>(config, result)
+                                       : runBenchmark<float>(config, result);
+
+                    if (! ok)
+                    {
+                        std::printf("%-7s %8d %6d %3d  layout not supported\n",
+                                    isDouble ? "double" : "float", sampleRate, blockSize, numChannels);
+                        continue;
+                    }
+
+                    std::printf("%-7s %8d %6d %3d %10.3f %10.2f %10.2f %10.2f %8.3f\n",
+                                isDouble ? "double" : "float", sampleRate, blockSize, numChannels,
+                                result.nsPerSample, result.p50Micros, result.p99Micros,
+                                result.maxMicros, result.realtimeCpuPercent);
+
+                    if (config.numWorkerThreads > 0)
+                    {
+                        const auto& stats = result.workerStats;
+                        const auto totalTasks = juce::jmax<juce::uint64>(1, stats.tasksOnWorkers + stats.tasksOnCaller);
+
+                        std::printf("        workers ran %.0f%% of tasks, %llu deadline misses, %llu single-thread fallback runs\n",
+                                    100.0 * static_cast<double>(stats.tasksOnWorkers) / static_cast<double>(totalTasks),
+                                    static_cast<unsigned long long>(stats.deadlineMisses),
+                                    static_cast<unsigned long long>(stats.inlineRuns));
+                    }
+                }
+            }
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,29 @@
+# Copies GCC profiles recorded by the benchmark to the names the plugin's
+# objects look for. With -fprofile-generate=DIR, GCC names each .gcda after
+# its object's absolute path with '/' mangled to '#', so the same source
+# built by two targets differs only in the CMakeFiles/<target>.dir part.
+#
+#   cmake -DPGO_DIR=<dir> -DFROM=<benchmark>.dir -DTO=<plugin>.dir -P CopyGccProfiles.cmake
+
+foreach(required PGO_DIR FROM TO)
+    if(NOT DEFINED ${required})
+        message(FATAL_ERROR "CopyGccProfiles.cmake needs -D${required}=...")
+    endif()
+endforeach()
+
+file(GLOB profiles "${PGO_DIR}/*#${FROM}#*.gcda")
+
+if(NOT profiles)
+    message(FATAL_ERROR "No benchmark profiles in ${PGO_DIR}: was it built with PLUGIN_PGO=GENERATE?")
+endif()
+
+set(numCopied 0)
+
+foreach(profile IN LISTS profiles)
+    get_filename_component(name "${profile}" NAME)
+    string(REPLACE "#${FROM}#" "#${TO}#" pluginName "${name}")
+    file(COPY_FILE "${profile}" "${PGO_DIR}/${pluginName}")
+    math(EXPR numCopied "${numCopied} + 1")
+endforeach()
+
+message(STATUS "Copied ${numCopied} profiles from ${FROM} to ${TO}")
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <array>
+#include <atomic>
+
+/**
+ * @brief Per-instance processBlock cost histogram
+ *
+ * processBlock wraps itself in a ScopedTimer, which reads the high-resolution
+ * clock twice and files the elapsed time into a log-scale histogram (four
+ * buckets per octave, 256 ns to ~270 ms). The audio thread is the only
+ * writer, so updates are plain relaxed load/store pairs with no locked
+ * instructions.
+ *
+ * Readers (the editor, the CSV log) take snapshots and compute statistics
+ * over the difference between two of them, so each reader gets its own
+ * window without resetting anything the others see. Percentiles are bucket
+ * upper edges, i.e. accurate to within a quarter octave. A snapshot is not
+ * atomic as a whole; counters may disagree by a block, which is irrelevant
+ * for statistics over hundreds of blocks.
+ */
+class BlockProfiler
+{
+public:
+    static constexpr int numBuckets = 81;
+
+    struct Snapshot
+    {
+        juce::uint64 numBlocks = 0;
+        juce::uint64 totalNanos = 0;
+        juce::uint64 totalAudioNanos = 0;
+        juce::uint64 maxNanos = 0;
+        std::array<juce::uint64, numBuckets> buckets {};
+    };
+
+    struct Stats
+    {
+        juce::uint64 numBlocks = 0;
+        double averageMicros = 0.0;
+        double p99Micros = 0.0;
+        double maxMicros = 0.0;      // since the last resetMax()
+        double budgetPercent = 0.0;  // time spent / duration of the audio processed
+    };
+
+    //==============================================================================
+    /** Call before playback starts (prepareToPlay). */
+    void prepare(double sampleRate) noexcept
+    {
+        nanosPerTick = 1.0e9 / static_cast<double>(juce::Time::getHighResolutionTicksPerSecond());
+        nanosPerSample = sampleRate > 0.0 ? 1.0e9 / sampleRate : 0.0;
+    }
+
+    /** Times one processBlock call. */
+    class ScopedTimer
+    {
+    public:
+        ScopedTimer(BlockProfiler& profilerToUse, int numSamplesInBlock) noexcept
+            : profiler(profilerToUse), numSamples(numSamplesInBlock), startTicks(juce::Time::getHighResolutionTicks())
+        {
+        }
+
+        ~ScopedTimer() noexcept
+        {
+            profiler.record(juce::Time::getHighResolutionTicks() - startTicks, numSamples);
+        }
+
+    private:
+        BlockProfiler& profiler;
+        const int numSamples;
+        const juce::int64 startTicks;
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedTimer)
+    };
+
+    /** Audio thread only. */
+    void record(juce::int64 elapsedTicks, int numSamples) noexcept
+    {
+        const auto nanos = static_cast<juce::uint64>(juce::jmax(0.0, static_cast<double>(elapsedTicks) * nanosPerTick));
+
+        if (maxResetPending.load(std::memory_order_relaxed))
+        {
+            maxResetPending.store(false, std::memory_order_relaxed);
+            maxNanos.store(0, std::memory_order_relaxed);
+        }
+
+        increment(buckets[static_cast<size_t>(getBucketIndex(nanos))], 1);
+        increment(totalNanos, nanos);
+        increment(totalAudioNanos, static_cast<juce::uint64>(static_cast<double>(numSamples) * nanosPerSample));
+        increment(numBlocks, 1);
+
+        if (nanos > maxNanos.load(std::memory_order_relaxed))
+            maxNanos.store(nanos, std::memory_order_relaxed);
+    }
+
+    //==============================================================================
+    /** Any thread. */
+    Snapshot getSnapshot() const noexcept;
+
+    /** Any thread. Asks the audio thread to restart the running maximum. */
+    void resetMax() noexcept { maxResetPending.store(true, std::memory_order_relaxed); }
+
+    /** Statistics for the blocks recorded between two snapshots. */
+    static Stats computeStats(const Snapshot& current, const Snapshot& previous) noexcept;
+
+    /** Upper edge of a bucket in nanoseconds. */
+    static juce::uint64 getBucketUpperNanos(int bucketIndex) noexcept;
+
+private:
+    //==============================================================================
+    static constexpr int firstOctave = 8; // bucket 0 holds everything below 2^8 ns
+    static constexpr int bucketsPerOctave = 4;
+
+    static int getBucketIndex(juce::uint64 nanos) noexcept
+    {
+        if (nanos < (juce::uint64(1) << firstOctave))
+            return 0;
+
+        const auto clamped = static_cast<juce::uint32>(juce::jmin(nanos, juce::uint64(0xffffffff)));
+        const auto octave = juce::findHighestSetBit(clamped);
+        const auto subBucket = static_cast<int>((clamped >> (octave - 2)) & 3);
+
+        return juce::jmin(numBuckets - 1, 1 + (octave - firstOctave) * bucketsPerOctave + subBucket);
+    }
+
+    static void increment(std::atomic<juce::uint64>& counter, juce::uint64 amount) noexcept
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    double nanosPerTick = 1.0;
+    double nanosPerSample = 0.0;
+
+    std::array<std::atomic<juce::uint64>, numBuckets> buckets {};
+    std::atomic<juce::uint64> numBlocks { 0 };
+    std::atomic<juce::uint64> totalNanos { 0 };
+    std::atomic<juce::uint64> totalAudioNanos { 0 };
+    std::atomic<juce::uint64> maxNanos { 0 };
+    std::atomic<bool> maxResetPending { false };
+};
+
+//==============================================================================
+/**
+ * @brief Appends a BlockProfiler's statistics to a CSV file from a background thread
+ *
+ * One row per interval: wall-clock time, blocks processed, the average and
+ * p99 block cost over that interval, the running maximum, and the share of
+ * the real-time budget used. The audio thread is never involved beyond its usual counters.
+ */
+class BlockProfilerLog : private juce::Thread
+{
+public:
+    BlockProfilerLog(const BlockProfiler& profilerToLog, const juce::File& csvFile, int intervalMilliseconds);
+    ~BlockProfilerLog() override;
+
+    const juce::File& getFile() const noexcept { return file; }
+
+private:
+    void run() override;
+
+    const BlockProfiler& profiler;
+    const juce::File file;
+    const int intervalMs;
+
+    JUCE_DECLARE_NON_COPYABLE(BlockProfilerLog)
+};
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <juce_dsp/juce_dsp.h>
+#include <functional>
+#include <optional>
+#include "SharedResourceCache.h"
+
+/**
+ * @brief Partitioned FFT convolution (cabinet IRs, EQ matching) for the chain
+ *
+ * Wraps one juce::dsp::Convolution per channel pair, since each engine
+ * handles at most a stereo pair.
+ *
+ * Loading never blocks the caller: reading, hashing, decoding and resampling
+ * run on a loader thread shared by every instance, and the result is handed
+ * to the engines back on the message thread (their shared
+ * ConvolutionMessageQueue takes commands from one thread only). FFT
+ * partitioning then runs on that queue's thread, and the finished engine is
+ * swapped into process() without locking (JUCE crossfades between IRs).
+ * Neither thread nor any IR memory exists until the first prepare() or load.
+ *
+ * The decoded IR and its copy resampled to the prepared rate come from the
+ * process-wide SharedResourceCache, keyed by a hash of the file or sample
+ * content, so instances loading the same IR decode and resample it once.
+ * That saves the decoded buffers only: every engine still takes its own copy
+ * of the samples and builds its own FFT partitions, which is most of the
+ * memory of a long IR and still grows with instances and channel pairs.
+ *
+ * The latency mode picks the partitioning:
+ * - zeroLatency: non-uniform, a short head partition plus FFT tail, no latency
+ * - lowestCpu:   uniform partitions of lowCpuLatencySamples, reported as latency
+ *
+ * Engines are built in prepare() (message thread), so the mode must only be
+ * changed while processing is stopped or the callback lock is held.
+ */
+class ConvolutionStage
+{
+public:
+    enum class LatencyMode
+    {
+        zeroLatency,
+        lowestCpu
+    };
+
+    static constexpr int zeroLatencyHeadSamples = 256;
+    static constexpr int lowCpuLatencySamples = 1024;
+
+    ConvolutionStage() = default;
+
+    //==============================================================================
+    /**
+     * Message thread. Rebuilds the engines and reloads the current IR into
+     * them: at once if the cache has it at this rate, otherwise once the
+     * loader has resampled it.
+     */
+    void prepare(const juce::dsp::ProcessSpec& spec, LatencyMode newMode);
+    void reset() noexcept;
+
+    LatencyMode getLatencyMode() const noexcept { return mode; }
+
+    //==============================================================================
+    /** Called on the message thread with whether the requested IR was loaded; not called if superseded. */
+    using LoadCallback = std::function<void(bool loaded)>;
+
+    /** Message thread. Returns at once; the file is read and decoded on the loader thread. */
+    void loadImpulseResponse(const juce::File& file, LoadCallback onLoaded = {});
+
+    /** Message thread. Returns at once; the buffer is hashed and resampled on the loader thread. */
+    void loadImpulseResponse(juce::AudioBuffer<float>&& impulseResponse, double impulseSampleRate,
+                             LoadCallback onLoaded = {});
+
+    /** Call under the callback lock. The stage passes audio through untouched until the next load. */
+    void clearImpulseResponse();
+
+    /** Message thread, after an IR reaches the engines: latency and tail may have changed. */
+    std::function<void()> onImpulseChanged;
+
+    //==============================================================================
+    /** True once an IR has reached the engines; until then process() should be skipped. */
+    bool isActive() const noexcept { return active.load(std::memory_order_acquire); }
+
+    /** Latency added by the stage while active. */
+    int getLatencySamples() const noexcept;
+
+    /** Length of the current IR at the prepared sample rate. */
+    int getTailSamples() const noexcept;
+
+    //==============================================================================
+    /** Audio thread. The block must not exceed the prepared size or channel count. */
+    void process(const juce::dsp::AudioBlock<float>& block) noexcept;
+
+    /** Audio or worker thread. Processes one channel pair; distinct pairs may run concurrently. */
+    void processPair(int pairIndex, const juce::dsp::AudioBlock<float>& block) noexcept;
+
+    /** Number of independent channel pairs for the given channel count. */
+    int getNumPairs(size_t numChannels) const noexcept;
+
+private:
+    //==============================================================================
+    /** Immutable, shared between instances through the cache. */
+    struct ImpulseResponse
+    {
+        juce::AudioBuffer<float> samples; // at most two channels
+        double sampleRate = 0.0;
+    };
+
+    /** One of file, buffer or an already decoded source, to bring to targetRate. */
+    struct LoadRequest
+    {
+        juce::File file;
+        std::shared_ptr<juce::AudioBuffer<float>> buffer;
+        double bufferSampleRate = 0.0;
+        std::shared_ptr<const ImpulseResponse> source;
+        juce::uint64 sourceHash = 0;
+        double targetRate = 0.0;
+        juce::uint32 generation = 0;
+    };
+
+    struct LoadResult
+    {
+        std::shared_ptr<const ImpulseResponse> source, prepared; // null if the load failed
+        juce::uint64 sourceHash = 0;
+        juce::uint32 generation = 0;
+    };
+
+    /** Shared by every instance, so a session loading many IRs uses one thread. */
+    struct Loader
+    {
+        juce::ThreadPool pool { juce::ThreadPoolOptions {}.withThreadName("IR loader").withNumberOfThreads(1) };
+    };
+
+    void requestLoad(LoadRequest request, LoadCallback onLoaded);
+    void publish(LoadResult result, LoadCallback onLoaded);
+    void loadIntoEngines();
+
+    static LoadResult runLoad(const LoadRequest& request, SharedResourceCache& cache);
+    static std::shared_ptr<const ImpulseResponse> decodeFile(const juce::File& file, juce::uint64& hash, SharedResourceCache& cache);
+    static std::shared_ptr<const ImpulseResponse> resample(const std::shared_ptr<const ImpulseResponse>& source, juce::uint64 hash,
+                                                           double targetRate, SharedResourceCache& cache);
+
+    // Declared before the engines so they're destroyed first
+    std::optional<juce::SharedResourcePointer<juce::dsp::ConvolutionMessageQueue>> queue;
+    std::vector<std::unique_ptr<juce::dsp::Convolution>> engines; // one per channel pair
+
+    juce::dsp::ProcessSpec preparedSpec { 0.0, 0, 0 };
+    LatencyMode mode = LatencyMode::zeroLatency;
+
+    // Current IR as loaded and at the prepared rate; kept so engines rebuilt in
+    // prepare() can reload it
+    juce::SharedResourcePointer<SharedResourceCache> resources;
+    std::shared_ptr<const ImpulseResponse> sourceImpulse;
+    std::shared_ptr<const ImpulseResponse> preparedImpulse;
+    juce::uint64 impulseHash = 0;
+
+    // Only the newest request is published; older results are dropped. The
+    // token lets a finished load find out whether the stage still exists.
+    std::optional<juce::SharedResourcePointer<Loader>> loader;
+    std::shared_ptr<ConvolutionStage*> lifetimeToken = std::make_shared<ConvolutionStage*>(this);
+    juce::uint32 requestedGeneration = 0;
+    juce::uint32 publishedGeneration = 0;
+
+    std::atomic<bool> active { false };
+
+    JUCE_DECLARE_NON_COPYABLE(ConvolutionStage)
+};
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <cstring>
+#include <type_traits>
+
+/**
+ * @brief Per-instance memory for DSP state and scratch buffers
+ *
+ * prepareToPlay works out how much memory the chain needs for the current
+ * ProcessSpec (bytesFor() per allocation), calls reset() with the total and
+ * then carves every buffer out of the arena with allocate(). Each allocation
+ * starts on its own cache line, allocations are laid out back to back in the
+ * order they are made, and the whole block is zeroed in reset() so no page
+ * is first touched on the audio thread.
+ *
+ * Nothing is freed individually: the next reset() invalidates every pointer
+ * handed out, so it must only be called while processing is stopped. The
+ * backing block is only reallocated when a prepare needs more than before.
+ */
+class DspArena
+{
+public:
+    static constexpr size_t alignment = 64; // cache line on every target we ship
+
+    //==============================================================================
+    /** Bytes reserved by allocate<T>(count), including alignment padding. */
+    template <typename T>
+    static constexpr size_t bytesFor(size_t count) noexcept
+    {
+        return (sizeof(T) * count + alignment - 1) & ~(alignment - 1);
+    }
+
+    /** Bytes reserved by allocateChannels<T>(numChannels, numSamples). */
+    template <typename T>
+    static constexpr size_t bytesForChannels(size_t numChannels, size_t numSamples) noexcept
+    {
+        return bytesFor<T*>(numChannels) + numChannels * bytesFor<T>(numSamples);
+    }
+
+    //==============================================================================
+    /** Message thread, processing stopped. Invalidates all previous allocations. */
+    void reset(size_t totalBytes)
+    {
+        if (totalBytes + alignment > storageSize)
+        {
+            storageSize = totalBytes + alignment;
+            storage.malloc(storageSize);
+        }
+
+        const auto address = reinterpret_cast<juce::pointer_sized_uint>(storage.get());
+        base = storage.get() + ((alignment - (address & (alignment - 1))) & (alignment - 1));
+        capacity = totalBytes;
+        used = 0;
+
+        if (capacity > 0)
+            std::memset(base, 0, capacity);
+    }
+
+    /** Releases the backing memory. */
+    void release() noexcept
+    {
+        storage.free();
+        storageSize = capacity = used = 0;
+        base = nullptr;
+    }
+
+    //==============================================================================
+    /** Returns zeroed, cache-line aligned storage for count objects, or nullptr if the arena is exhausted. */
+    template <typename T>
+    T* allocate(size_t count) noexcept
+    {
+        static_assert(std::is_trivially_destructible_v<T>, "the arena never runs destructors");
+        static_assert(alignof(T) <= alignment, "over-aligned types are not supported");
+
+        const auto bytes = bytesFor<T>(count);
+
+        if (count == 0 || used + bytes > capacity)
+        {
+            jassert(count == 0); // reset() was given too small a total
+            return nullptr;
+        }
+
+        auto* result = reinterpret_cast<T*>(base + used);
+        used += bytes;
+        return result;
+    }
+
+    /** Allocates one buffer per channel plus the table of channel pointers (also in the arena). */
+    template <typename T>
+    T** allocateChannels(size_t numChannels, size_t numSamples) noexcept
+    {
+        auto** channels = allocate<T*>(numChannels);
+
+        if (channels == nullptr)
+            return nullptr;
+
+        for (size_t ch = 0; ch < numChannels; ++ch)
+            if ((channels[ch] = allocate<T>(numSamples)) == nullptr)
+                return nullptr;
+
+        return channels;
+    }
+
+    size_t getCapacity() const noexcept    { return capacity; }
+    size_t getBytesUsed() const noexcept   { return used; }
+
+private:
+    //==============================================================================
+    juce::HeapBlock<char> storage;
+    size_t storageSize = 0;
+    char* base = nullptr;
+    size_t capacity = 0;
+    size_t used = 0;
+};
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+
+/**
+ * @brief Auto-vectorised inner loops, compiled once per CPU target
+ *
+ * Unlike GainKernels, nothing here uses intrinsics: the loops are plain C++
+ * written so the compiler vectorises them (FastMath's exp2 ramp for
+ * GainStage, the input sanitiser's scan), and what they gain from a wider
+ * target is decided by build flags. source/DspCoreKernels.cpp is compiled
+ * once for the baseline target and once more for each entry in the CMake
+ * cache variable PLUGIN_CPU_VARIANTS (avx2, avx512, apple_arm64), each copy
+ * in its own namespace. getBestVariant() picks the widest copy this binary
+ * contains and this CPU can run.
+ *
+ * Look kernels up once (prepare() or the constructor) and call through the
+ * table, as with GainKernels.
+ */
+namespace DspCore
+{
+    //==============================================================================
+    enum class Variant
+    {
+        baseline,
+        avx2,         // AVX2 + FMA
+        avx512,       // AVX-512 F/VL/DQ/BW/CD, AVX2, FMA
+        appleSilicon  // -mcpu=apple-m1, arm64 macOS only
+    };
+
+    template <typename SampleType>
+    struct Kernels
+    {
+        /** destination[i] = 2^(startLog2 + stepLog2 * (i + 1)), through FastMath::exp2. */
+        void (*fillExp2Ramp)(SampleType* destination, int numSamples,
+                             SampleType startLog2, SampleType stepLog2) noexcept;
+
+        /** Raises peak to max |x| over data; true if any sample is non-finite or subnormal. */
+        bool (*scanForRepair)(const SampleType* data, size_t numSamples, SampleType& peak) noexcept;
+    };
+
+    struct VariantKernels
+    {
+        Kernels<float> floatKernels;
+        Kernels<double> doubleKernels;
+    };
+
+    //==============================================================================
+    /** True if the variant was compiled into this binary. */
+    bool isBuilt(Variant variant) noexcept;
+
+    /** True if the variant was built and the running CPU can execute it. */
+    bool isSupported(Variant variant) noexcept;
+
+    /** Widest supported variant, detected once and cached. */
+    Variant getBestVariant() noexcept;
+
+    const char* getName(Variant variant) noexcept;
+
+    /** Returns the variant's kernels, or the baseline ones if it is unsupported. */
+    template <typename SampleType>
+    const Kernels<SampleType>& getKernels(Variant variant) noexcept;
+
+    template <>
+    const Kernels<float>& getKernels<float>(Variant variant) noexcept;
+
+    template <>
+    const Kernels<double>& getKernels<double>(Variant variant) noexcept;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+/**
+ * @brief SIMD gain-ramp kernels with runtime CPU dispatch
+ *
+ * Each kernel multiplies one or two channels by the linear ramp
+ * start + step * (i + 1), sharing a single ramp register between the two
+ * channels so stereo ramps cost one ramp computation per vector.
+ *
+ * Measure kernels compute a channel's peak and sum of squares in one pass
+ * for metering, using the same dispatch.
+ *
+ * Kernels are looked up once (GainStage does this in prepare()) and called
+ * through a plain function pointer, so the audio thread never branches on
+ * CPU features.
+ */
+namespace GainKernels
+{
+    //==============================================================================
+    enum class InstructionSet
+    {
+        scalar,
+        sse2,
+        avx2,
+        avx512,
+        neon
+    };
+
+    /** Multiplies first (and second, if not nullptr) by start + step * (i + 1). */
+    template <typename SampleType>
+    using RampKernel = void (*)(SampleType* first, SampleType* second, int numSamples,
+                                SampleType start, SampleType step) noexcept;
+
+    /** Writes max |x| and sum of x^2 over data into peak and sumOfSquares. */
+    template <typename SampleType>
+    using MeasureKernel = void (*)(const SampleType* data, int numSamples,
+                                   SampleType& peak, SampleType& sumOfSquares) noexcept;
+
+    //==============================================================================
+    /** True if the running CPU (and this build) can execute the given kernels. */
+    bool isSupported(InstructionSet instructionSet) noexcept;
+
+    /** Widest supported instruction set, detected once and cached. */
+    InstructionSet getBestInstructionSet() noexcept;
+
+    const char* getName(InstructionSet instructionSet) noexcept;
+
+    /** Returns the kernel for the given instruction set, or the scalar one if unsupported. */
+    template <typename SampleType>
+    RampKernel<SampleType> getRampKernel(InstructionSet instructionSet) noexcept;
+
+    template <>
+    RampKernel<float> getRampKernel<float>(InstructionSet instructionSet) noexcept;
+
+    template <>
+    RampKernel<double> getRampKernel<double>(InstructionSet instructionSet) noexcept;
+
+    /** Returns the measure kernel for the given instruction set, or the scalar one if unsupported. */
+    template <typename SampleType>
+    MeasureKernel<SampleType> getMeasureKernel(InstructionSet instructionSet) noexcept;
+
+    template <>
+    MeasureKernel<float> getMeasureKernel<float>(InstructionSet instructionSet) noexcept;
+
+    template <>
+    MeasureKernel<double> getMeasureKernel<double>(InstructionSet instructionSet) noexcept;
+}
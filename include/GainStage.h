@@ -0,0 +1,235 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_dsp/juce_dsp.h>
+#include "DspCore.h"
+#include "FastMath.h"
+#include "GainKernels.h"
+
+/**
+ * @brief Gain with a per-sample ramp, linear or in decibels
+ *
+ * Replaces juce::dsp::Gain in the processing chain. Linear ramps run through
+ * the SIMD kernel picked for this CPU in prepare() (see GainKernels.h), and
+ * settled gain uses FloatVectorOperations, so no path is sample-by-sample.
+ *
+ * setTargetDecibels() ramps evenly in dB instead, which is what a level
+ * change sounds smooth in: FastMath::exp2 turns each sample's log-gain into a
+ * linear factor, a chunk at a time, so the curve is exact per sample at
+ * roughly the cost of a vector multiply. That loop comes from the DspCore
+ * variant picked for this CPU in prepare(). Ramps from or to silence stay
+ * linear, since zero has no log.
+ *
+ * The ramp length can be given per target, which lets the processor
+ * interpolate automation across a whole block instead of jumping at block
+ * boundaries.
+ *
+ * Once the ramp has settled, unity gain leaves the buffer untouched and zero
+ * gain clears it, so an instance parked at 0 dB costs no buffer writes.
+ */
+template <typename SampleType>
+class GainStage
+{
+public:
+    //==============================================================================
+    void prepare(const juce::dsp::ProcessSpec& spec)
+    {
+        sampleRate = spec.sampleRate;
+        rampKernel = GainKernels::getRampKernel<SampleType>(GainKernels::getBestInstructionSet());
+        dspKernels = &DspCore::getKernels<SampleType>(DspCore::getBestVariant());
+        setRampDurationSeconds(rampDurationSeconds);
+        reset();
+    }
+
+    void reset() noexcept
+    {
+        currentGain = targetGain;
+        step = SampleType(0);
+        samplesRemaining = 0;
+        rampInDecibels = false;
+    }
+
+    /** Default ramp length used by setTargetGain(SampleType). */
+    void setRampDurationSeconds(double newDurationSeconds) noexcept
+    {
+        rampDurationSeconds = newDurationSeconds;
+        defaultRampSamples = juce::jmax(1, juce::roundToInt(sampleRate * rampDurationSeconds));
+    }
+
+    //==============================================================================
+    /** Decibel level at or below which setTargetDecibels() produces silence. */
+    void setMinusInfinityDecibels(SampleType newMinusInfinityDb) noexcept
+    {
+        minusInfinityDb = newMinusInfinityDb;
+        lastDecibels = std::numeric_limits<SampleType>::quiet_NaN(); // force reconversion
+    }
+
+    /** Ramps evenly in dB towards a new level over the default ramp length. */
+    void setTargetDecibels(SampleType newDecibels) noexcept
+    {
+        setTargetDecibels(newDecibels, defaultRampSamples);
+    }
+
+    /** Ramps evenly in dB over exactly numSamples; skips the conversion when the level is unchanged. */
+    void setTargetDecibels(SampleType newDecibels, int numSamples) noexcept
+    {
+        const auto newGain = decibelsToGainCached(newDecibels);
+
+        if (newGain == targetGain)
+            return;
+
+        if (numSamples <= 0 || newGain <= SampleType(0) || currentGain <= SampleType(0))
+        {
+            setTargetGain(newGain, numSamples);
+            return;
+        }
+
+        targetGain = newGain;
+        samplesRemaining = numSamples;
+        rampInDecibels = true;
+        currentLog2 = std::log2(currentGain);
+        log2Step = (std::log2(targetGain) - currentLog2) / static_cast<SampleType>(numSamples);
+    }
+
+    /** Ramps towards a new linear gain over the default ramp length. */
+    void setTargetGain(SampleType newGain) noexcept
+    {
+        setTargetGain(newGain, defaultRampSamples);
+    }
+
+    /** Ramps towards a new linear gain over exactly numSamples samples. */
+    void setTargetGain(SampleType newGain, int numSamples) noexcept
+    {
+        if (newGain == targetGain)
+            return;
+
+        targetGain = newGain;
+
+        if (numSamples <= 0)
+        {
+            reset();
+            return;
+        }
+
+        samplesRemaining = numSamples;
+        rampInDecibels = false;
+        step = (targetGain - currentGain) / static_cast<SampleType>(numSamples);
+    }
+
+    void setCurrentAndTargetGain(SampleType newGain) noexcept
+    {
+        targetGain = newGain;
+        reset();
+    }
+
+    SampleType getCurrentGain() const noexcept { return currentGain; }
+    SampleType getTargetGain() const noexcept { return targetGain; }
+    bool isSmoothing() const noexcept { return samplesRemaining > 0; }
+
+    //==============================================================================
+    void process(const juce::dsp::AudioBlock<SampleType>& block) noexcept
+    {
+        const auto numChannels = block.getNumChannels();
+        const auto numSamples = static_cast<int>(block.getNumSamples());
+        int offset = 0;
+
+        jassert(rampKernel != nullptr); // prepare() must be called first
+
+        if (isSmoothing())
+        {
+            const auto rampSamples = juce::jmin(numSamples, samplesRemaining);
+
+            if (rampInDecibels)
+            {
+                rampDecibels(block, rampSamples);
+                samplesRemaining -= rampSamples;
+                currentGain = samplesRemaining > 0 ? FastMath::exp2(currentLog2) : targetGain;
+            }
+            else
+            {
+                // Channels go through the kernel in pairs that share one ramp register
+                for (size_t ch = 0; ch < numChannels; ch += 2)
+                    rampKernel(block.getChannelPointer(ch),
+                               ch + 1 < numChannels ? block.getChannelPointer(ch + 1) : nullptr,
+                               rampSamples, currentGain, step);
+
+                samplesRemaining -= rampSamples;
+                currentGain = samplesRemaining > 0 ? currentGain + step * static_cast<SampleType>(rampSamples)
+                                                   : targetGain;
+            }
+
+            rampInDecibels = rampInDecibels && samplesRemaining > 0;
+            offset = rampSamples;
+        }
+
+        const auto remaining = numSamples - offset;
+
+        // Settled: unity is a pass-through for the rest of the block
+        if (remaining <= 0 || currentGain == SampleType(1))
+            return;
+
+        for (size_t ch = 0; ch < numChannels; ++ch)
+        {
+            auto* data = block.getChannelPointer(ch) + offset;
+
+            if (currentGain == SampleType(0))
+                juce::FloatVectorOperations::clear(data, remaining);
+            else
+                juce::FloatVectorOperations::multiply(data, currentGain, remaining);
+        }
+    }
+
+private:
+    //==============================================================================
+    static constexpr int decibelChunkSize = 64;
+
+    /** Gains for a chunk at a time into a stack buffer, then one vector multiply per channel. */
+    void rampDecibels(const juce::dsp::AudioBlock<SampleType>& block, int rampSamples) noexcept
+    {
+        SampleType gains[decibelChunkSize];
+
+        for (int start = 0; start < rampSamples; start += decibelChunkSize)
+        {
+            const auto chunkSamples = juce::jmin(decibelChunkSize, rampSamples - start);
+
+            // Same convention as the linear kernels: sample i gets start + step * (i + 1)
+            dspKernels->fillExp2Ramp(gains, chunkSamples, currentLog2, log2Step);
+
+            for (size_t ch = 0; ch < block.getNumChannels(); ++ch)
+                juce::FloatVectorOperations::multiply(block.getChannelPointer(ch) + start, gains, chunkSamples);
+
+            currentLog2 += log2Step * static_cast<SampleType>(chunkSamples);
+        }
+    }
+
+    SampleType decibelsToGainCached(SampleType newDecibels) noexcept
+    {
+        if (newDecibels != lastDecibels)
+        {
+            lastDecibels = newDecibels;
+            lastLinearGain = FastMath::decibelsToGain(newDecibels, minusInfinityDb);
+        }
+
+        return lastLinearGain;
+    }
+
+    //==============================================================================
+    GainKernels::RampKernel<SampleType> rampKernel = nullptr;
+    const DspCore::Kernels<SampleType>* dspKernels = nullptr;
+    double sampleRate = 44100.0;
+    double rampDurationSeconds = 0.05;
+    int defaultRampSamples = 1;
+
+    SampleType currentGain = SampleType(1);
+    SampleType targetGain = SampleType(1);
+    SampleType step = SampleType(0);
+    int samplesRemaining = 0;
+
+    bool rampInDecibels = false;
+    SampleType currentLog2 = SampleType(0); // log2 of currentGain during a dB ramp
+    SampleType log2Step = SampleType(0);
+
+    SampleType minusInfinityDb = SampleType(-100);
+    SampleType lastDecibels = SampleType(0);
+    SampleType lastLinearGain = SampleType(1);
+};
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <array>
+#include <atomic>
+
+/**
+ * @brief Per-channel output levels passed from the audio thread to the editor
+ *
+ * processBlock measures each output channel once per block (only while
+ * metering is enabled) and publishes the results through relaxed atomics.
+ * The editor polls at its frame rate: peaks accumulate between polls and are
+ * reset by the reader, so short transients are never missed; RMS is the most
+ * recent block's value. Neither side locks or waits on the other.
+ */
+class LevelMeters
+{
+public:
+    static constexpr int maxChannels = 64;
+
+    //==============================================================================
+    /** Metering costs a pass over the output, so it only runs while an editor is showing. */
+    void setEnabled(bool shouldBeEnabled) noexcept   { enabled.store(shouldBeEnabled, std::memory_order_relaxed); }
+    bool isEnabled() const noexcept                  { return enabled.load(std::memory_order_relaxed); }
+
+    int getNumChannels() const noexcept              { return numChannels.load(std::memory_order_relaxed); }
+
+    //==============================================================================
+    /** Audio thread only. */
+    void setNumChannels(int newNumChannels) noexcept
+    {
+        numChannels.store(juce::jlimit(0, maxChannels, newNumChannels), std::memory_order_relaxed);
+    }
+
+    /** Audio thread only. Peaks are held until the next readPeak(). */
+    void publish(int channel, float peak, float rms) noexcept
+    {
+        if (! juce::isPositiveAndBelow(channel, maxChannels))
+            return;
+
+        auto& level = levels[static_cast<size_t>(channel)];
+
+        // Single writer, so load + store is enough; a reset that slips in
+        // between just holds the peak for one more frame
+        if (peak > level.peak.load(std::memory_order_relaxed))
+            level.peak.store(peak, std::memory_order_relaxed);
+
+        level.rms.store(rms, std::memory_order_relaxed);
+    }
+
+    //==============================================================================
+    /** Editor thread. Returns the highest peak since the last call and resets it. */
+    float readPeak(int channel) noexcept
+    {
+        return juce::isPositiveAndBelow(channel, maxChannels)
+                   ? levels[static_cast<size_t>(channel)].peak.exchange(0.0f, std::memory_order_relaxed)
+                   : 0.0f;
+    }
+
+    float getRms(int channel) const noexcept
+    {
+        return juce::isPositiveAndBelow(channel, maxChannels)
+                   ? levels[static_cast<size_t>(channel)].rms.load(std::memory_order_relaxed)
+                   : 0.0f;
+    }
+
+private:
+    //==============================================================================
+    struct Level
+    {
+        std::atomic<float> peak { 0.0f };
+        std::atomic<float> rms { 0.0f };
+    };
+
+    std::array<Level, maxChannels> levels;
+    std::atomic<int> numChannels { 0 };
+    std::atomic<bool> enabled { false };
+};
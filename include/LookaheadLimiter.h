@@ -0,0 +1,220 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_dsp/juce_dsp.h>
+#include "DspArena.h"
+#include "InputSanitiser.h"
+
+/**
+ * @brief Transparent peak limiter with a look-ahead delay
+ *
+ * The input is delayed by the look-ahead time while a peak detector scans
+ * the undelayed signal, so gain reduction is fully in place by the time a
+ * peak leaves the delay line and no sample exceeds the ceiling:
+ *
+ * 1. the linked peak of all channels is held over the look-ahead window
+ *    (a monotonic queue, O(1) per sample),
+ * 2. the gain that peak needs is averaged over the same window, which turns
+ *    the attack into a smooth ramp that ends exactly on the peak,
+ * 3. releases follow a one-pole curve that never rises above that gain.
+ *
+ * All memory comes from the DspArena at the longest look-ahead the processor
+ * offers, so changing it never allocates; setLookaheadSamples() only resets
+ * state, and must be called while processBlock is locked out because the
+ * reported latency changes with it. Zero look-ahead disables the limiter and
+ * leaves the block untouched.
+ */
+template <typename SampleType>
+class LookaheadLimiter
+{
+public:
+    //==============================================================================
+    /** Arena bytes prepare() takes for this channel count and look-ahead. */
+    static constexpr size_t bytesRequired(size_t numChannels, int maxLookaheadSamples) noexcept
+    {
+        const auto windowSize = static_cast<size_t>(maxLookaheadSamples) + 1;
+
+        return DspArena::bytesForChannels<SampleType>(numChannels, windowSize) // delay lines
+             + DspArena::bytesFor<SampleType>(windowSize)                      // peak queue values
+             + DspArena::bytesFor<juce::int64>(windowSize)                     // peak queue positions
+             + DspArena::bytesFor<double>(windowSize);                         // gain averaging history
+    }
+
+    /** Message thread, processing stopped. Takes its memory from the arena. */
+    void prepare(double newSampleRate, int newNumChannels, int newMaxLookaheadSamples, DspArena& arena) noexcept
+    {
+        sampleRate = newSampleRate;
+        numChannels = newNumChannels;
+        maxLookaheadSamples = newMaxLookaheadSamples;
+
+        const auto windowSize = static_cast<size_t>(maxLookaheadSamples) + 1;
+        delayLines = arena.allocateChannels<SampleType>(static_cast<size_t>(numChannels), windowSize);
+        peakValues = arena.allocate<SampleType>(windowSize);
+        peakPositions = arena.allocate<juce::int64>(windowSize);
+        gainHistory = arena.allocate<double>(windowSize);
+
+        setReleaseSeconds(releaseSeconds);
+        setLookaheadSamples(juce::jmin(lookaheadSamples, maxLookaheadSamples));
+    }
+
+    /** Drops the arena memory (e.g. for the chain that won't run); the limiter is then disabled. */
+    void release() noexcept
+    {
+        delayLines = nullptr;
+        peakValues = nullptr;
+        peakPositions = nullptr;
+        gainHistory = nullptr;
+        maxLookaheadSamples = 0;
+    }
+
+    /** Call with processBlock locked out; resets all state. */
+    void setLookaheadSamples(int newLookaheadSamples) noexcept
+    {
+        lookaheadSamples = juce::jlimit(0, maxLookaheadSamples, newLookaheadSamples);
+        reset();
+    }
+
+    int getLookaheadSamples() const noexcept { return lookaheadSamples; }
+
+    /** True when look-ahead is set and prepare() got its memory. */
+    bool isEnabled() const noexcept { return lookaheadSamples > 0 && gainHistory != nullptr; }
+
+    //==============================================================================
+    void setCeilingDecibels(SampleType newCeilingDb) noexcept
+    {
+        ceiling = juce::Decibels::decibelsToGain(newCeilingDb);
+    }
+
+    void setReleaseSeconds(double newReleaseSeconds) noexcept
+    {
+        releaseSeconds = newReleaseSeconds;
+
+        if (sampleRate > 0.0)
+            releaseCoefficient = 1.0 - std::exp(-1.0 / (releaseSeconds * sampleRate));
+    }
+
+    void reset() noexcept
+    {
+        if (gainHistory == nullptr)
+            return;
+
+        const auto windowSize = static_cast<size_t>(lookaheadSamples) + 1;
+
+        for (int ch = 0; ch < numChannels; ++ch)
+            std::fill(delayLines[ch], delayLines[ch] + windowSize, SampleType(0));
+
+        std::fill(gainHistory, gainHistory + windowSize, 1.0);
+        gainSum = static_cast<double>(windowSize);
+        queueHead = queueSize = 0;
+        position = 0;
+        writeIndex = 0;
+        delayIndex = 0;
+        currentGain = 1.0;
+    }
+
+    //==============================================================================
+    /** Audio thread. Delays the block by the look-ahead and limits it to the ceiling. */
+    void process(const juce::dsp::AudioBlock<SampleType>& block) noexcept
+    {
+        if (! isEnabled())
+            return;
+
+        const auto channels = juce::jmin(numChannels, static_cast<int>(block.getNumChannels()));
+        const auto numSamples = static_cast<int>(block.getNumSamples());
+        const auto windowSize = lookaheadSamples + 1;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            // Linked peak of the incoming (undelayed) sample
+            SampleType peak(0);
+
+            for (int ch = 0; ch < channels; ++ch)
+                peak = juce::jmax(peak, std::abs(block.getSample(ch, i)));
+
+            const auto heldPeak = pushPeak(peak, windowSize);
+            const auto requiredGain = heldPeak > ceiling ? static_cast<double>(ceiling / heldPeak) : 1.0;
+
+            // Moving average over the window: the ramp reaches requiredGain
+            // exactly when this sample leaves the delay line
+            gainSum += requiredGain - gainHistory[writeIndex];
+            gainHistory[writeIndex] = requiredGain;
+            const auto smoothedGain = juce::jmin(1.0, gainSum / static_cast<double>(windowSize));
+
+            currentGain = smoothedGain < currentGain ? smoothedGain
+                                                     : currentGain + (smoothedGain - currentGain) * releaseCoefficient;
+
+            // A peak entering now is limited by gainHistory's full window, which
+            // is lookaheadSamples later: exactly the delay
+            for (int ch = 0; ch < channels; ++ch)
+            {
+                auto* delay = delayLines[ch];
+                const auto delayed = delay[delayIndex];
+                delay[delayIndex] = InputSanitiser::flushSubnormal(block.getSample(ch, i));
+                block.setSample(ch, i, static_cast<SampleType>(static_cast<double>(delayed) * currentGain));
+            }
+
+            if (++writeIndex == windowSize)
+                writeIndex = 0;
+
+            if (++delayIndex == lookaheadSamples)
+                delayIndex = 0;
+
+            ++position;
+        }
+
+        // The release recurrence and the running sum only ever approach their
+        // targets, so keep them out of the subnormal range with FTZ off
+        currentGain = InputSanitiser::flushSubnormal(currentGain);
+        gainSum = InputSanitiser::flushSubnormal(gainSum);
+    }
+
+private:
+    //==============================================================================
+    /** Adds a peak and returns the maximum over the last windowSize samples. */
+    SampleType pushPeak(SampleType peak, int windowSize) noexcept
+    {
+        auto slot = [this, windowSize](int index) { return (queueHead + index) % windowSize; };
+
+        // Expire the oldest entry once it's outside the window
+        if (queueSize > 0 && peakPositions[queueHead] <= position - windowSize)
+        {
+            queueHead = slot(1);
+            --queueSize;
+        }
+
+        // Smaller entries can never be the maximum again
+        while (queueSize > 0 && peakValues[slot(queueSize - 1)] <= peak)
+            --queueSize;
+
+        const auto tail = slot(queueSize);
+        peakValues[tail] = peak;
+        peakPositions[tail] = position;
+        ++queueSize;
+
+        return peakValues[queueHead];
+    }
+
+    double sampleRate = 0.0;
+    int numChannels = 0;
+    int maxLookaheadSamples = 0;
+    int lookaheadSamples = 0;
+
+    SampleType ceiling = SampleType(1);
+    double releaseSeconds = 0.1;
+    double releaseCoefficient = 1.0;
+
+    // Arena memory for the longest look-ahead; the delay lines use
+    // lookaheadSamples entries, everything else windowSize = lookaheadSamples + 1
+    SampleType** delayLines = nullptr;
+    SampleType* peakValues = nullptr;
+    juce::int64* peakPositions = nullptr;
+    double* gainHistory = nullptr;
+
+    double gainSum = 0.0;
+    double currentGain = 1.0;
+    int queueHead = 0;
+    int queueSize = 0;
+    int writeIndex = 0; // gainHistory, wraps at windowSize
+    int delayIndex = 0; // delayLines, wraps at lookaheadSamples
+    juce::int64 position = 0;
+};
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <array>
+#include <atomic>
+
+/**
+ * @brief MIDI CC to parameter assignments, looked up in O(1) per event
+ *
+ * One flat, preallocated table entry per (channel, controller) pair, plus an
+ * omni row that matches any channel, each holding a parameter index or
+ * unmapped. Entries are atomics, so the editor can edit assignments while
+ * processBlock reads them, and a lookup is at most two relaxed loads.
+ *
+ * Learning: startLearning(parameterIndex) arms the map, and the next CC that
+ * reaches processBlock is assigned to that parameter on its own channel.
+ * Assignments are saved with the plugin state (see StateFormat.h).
+ */
+class MidiControlMap
+{
+public:
+    static constexpr int numMidiChannels = 16;
+    static constexpr int numControllers = 128;
+    static constexpr int omni = 0; // channel argument that matches every channel
+    static constexpr int unmapped = -1;
+
+    MidiControlMap() noexcept
+    {
+        for (auto& entry : table)
+            entry.store(unmapped, std::memory_order_relaxed);
+    }
+
+    //==============================================================================
+    /** Any thread. midiChannel is 1..16, or omni. */
+    void setMapping(int midiChannel, int controller, int parameterIndex) noexcept
+    {
+        if (auto* entry = getEntry(midiChannel, controller))
+        {
+            const auto previous = entry->exchange(static_cast<juce::int16>(parameterIndex), std::memory_order_relaxed);
+            numMappings.fetch_add((previous == unmapped ? 1 : 0) - (parameterIndex == unmapped ? 1 : 0),
+                                  std::memory_order_relaxed);
+        }
+    }
+
+    void clearMapping(int midiChannel, int controller) noexcept { setMapping(midiChannel, controller, unmapped); }
+
+    /** Any thread. Removes every assignment of a parameter. */
+    void clearMappingsFor(int parameterIndex) noexcept
+    {
+        for (int channel = omni; channel <= numMidiChannels; ++channel)
+            for (int controller = 0; controller < numControllers; ++controller)
+                if (getEntry(channel, controller)->load(std::memory_order_relaxed) == parameterIndex)
+                    clearMapping(channel, controller);
+    }
+
+    /** Any thread. Removes every assignment; learning stays armed if it was. */
+    void clearAll() noexcept
+    {
+        for (int channel = omni; channel <= numMidiChannels; ++channel)
+            for (int controller = 0; controller < numControllers; ++controller)
+                clearMapping(channel, controller);
+    }
+
+    /** Calls visitor(midiChannel, controller, parameterIndex) for every assignment, omni first. */
+    template <typename Visitor>
+    void forEachMapping(Visitor&& visitor) const
+    {
+        for (int channel = omni; channel <= numMidiChannels; ++channel)
+        {
+            for (int controller = 0; controller < numControllers; ++controller)
+            {
+                const auto parameterIndex = table[static_cast<size_t>(channel * numControllers + controller)].load(std::memory_order_relaxed);
+
+                if (parameterIndex != unmapped)
+                    visitor(channel, controller, static_cast<int>(parameterIndex));
+            }
+        }
+    }
+
+    int getNumMappings() const noexcept { return numMappings.load(std::memory_order_relaxed); }
+
+    //==============================================================================
+    /** Audio thread. The parameter a CC drives, or unmapped; an exact channel beats omni. */
+    int getParameterIndex(int midiChannel, int controller) const noexcept
+    {
+        if (! juce::isPositiveAndNotGreaterThan(midiChannel, numMidiChannels)
+            || ! juce::isPositiveAndBelow(controller, numControllers))
+            return unmapped;
+
+        const auto exact = table[static_cast<size_t>(midiChannel * numControllers + controller)].load(std::memory_order_relaxed);
+        return exact != unmapped ? exact : table[static_cast<size_t>(controller)].load(std::memory_order_relaxed);
+    }
+
+    /** True if any CC is assigned or learning is armed, i.e. processBlock should look at CCs at all. */
+    bool isActive() const noexcept
+    {
+        return numMappings.load(std::memory_order_relaxed) > 0 || learningParameter.load(std::memory_order_relaxed) != unmapped;
+    }
+
+    //==============================================================================
+    void startLearning(int parameterIndex) noexcept { learningParameter.store(parameterIndex, std::memory_order_relaxed); }
+    void stopLearning() noexcept                    { learningParameter.store(unmapped, std::memory_order_relaxed); }
+    int getLearningParameter() const noexcept       { return learningParameter.load(std::memory_order_relaxed); }
+
+    /** Audio thread. If learning is armed, assigns this CC to the armed parameter and disarms. */
+    bool learn(int midiChannel, int controller) noexcept
+    {
+        const auto parameterIndex = learningParameter.load(std::memory_order_relaxed);
+
+        if (parameterIndex == unmapped || getEntry(midiChannel, controller) == nullptr)
+            return false;
+
+        setMapping(midiChannel, controller, parameterIndex);
+        learningParameter.store(unmapped, std::memory_order_relaxed);
+        return true;
+    }
+
+private:
+    //==============================================================================
+    std::atomic<juce::int16>* getEntry(int midiChannel, int controller) noexcept
+    {
+        if (! juce::isPositiveAndNotGreaterThan(midiChannel, numMidiChannels)
+            || ! juce::isPositiveAndBelow(controller, numControllers))
+            return nullptr;
+
+        return &table[static_cast<size_t>(midiChannel * numControllers + controller)];
+    }
+
+    // Row 0 is omni, rows 1..16 are MIDI channels
+    std::array<std::atomic<juce::int16>, (numMidiChannels + 1) * numControllers> table;
+    std::atomic<int> numMappings { 0 };
+    std::atomic<int> learningParameter { unmapped };
+
+    JUCE_DECLARE_NON_COPYABLE(MidiControlMap)
+};
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <array>
+#include <atomic>
+
+//==============================================================================
+/** A parameter change, timestamped relative to the start of the next block. */
+struct ParameterEvent
+{
+    int parameterIndex = 0; // index into AudioProcessor::getParameters()
+    float value = 0.0f;     // normalised 0..1
+    int sampleOffset = 0;
+};
+
+/**
+ * @brief Bounded lock-free queue of parameter changes for the audio thread
+ *
+ * Parameter listeners push events and processBlock drains them, so the audio
+ * thread only touches parameters that actually changed. There is a single
+ * consumer (the audio thread), but push() may be called from several threads
+ * at once: JUCE notifies parameter listeners on whichever thread set the
+ * value, which can be the message thread, a host thread or the audio thread.
+ * Slots carry their own sequence numbers (Vyukov's bounded queue), so
+ * neither side ever blocks.
+ *
+ * If the queue fills up, push() drops the event and raises an overflow flag;
+ * the consumer then re-reads every parameter instead.
+ */
+class ParameterEventQueue
+{
+public:
+    static constexpr size_t capacity = 1024; // must be a power of two
+
+    //==============================================================================
+    ParameterEventQueue() noexcept
+    {
+        for (size_t i = 0; i < capacity; ++i)
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    /** Any thread. Returns false (and flags an overflow) if the queue is full. */
+    bool push(const ParameterEvent& event) noexcept
+    {
+        auto position = enqueuePosition.load(std::memory_order_relaxed);
+
+        for (;;)
+        {
+            auto& slot = slots[position & mask];
+            const auto sequence = slot.sequence.load(std::memory_order_acquire);
+            const auto difference = static_cast<std::ptrdiff_t>(sequence - position);
+
+            if (difference == 0)
+            {
+                if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    slot.event = event;
+                    slot.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (difference < 0)
+            {
+                overflowed.store(true, std::memory_order_release);
+                return false;
+            }
+            else
+            {
+                position = enqueuePosition.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /** Audio thread only. Calls handler(event) for every queued event, oldest first. */
+    template <typename Handler>
+    int drain(Handler&& handler) noexcept
+    {
+        int numDrained = 0;
+
+        for (;;)
+        {
+            auto& slot = slots[dequeuePosition & mask];
+            const auto sequence = slot.sequence.load(std::memory_order_acquire);
+
+            if (static_cast<std::ptrdiff_t>(sequence - (dequeuePosition + 1)) < 0)
+                return numDrained;
+
+            handler(slot.event);
+            slot.sequence.store(dequeuePosition + capacity, std::memory_order_release);
+            ++dequeuePosition;
+            ++numDrained;
+        }
+    }
+
+    /** Audio thread only. True if events were dropped since the last call. */
+    bool checkAndClearOverflow() noexcept
+    {
+        return overflowed.exchange(false, std::memory_order_acq_rel);
+    }
+
+private:
+    //==============================================================================
+    static constexpr size_t mask = capacity - 1;
+    static_assert((capacity & mask) == 0, "capacity must be a power of two");
+
+    struct Slot
+    {
+        std::atomic<size_t> sequence { 0 };
+        ParameterEvent event;
+    };
+
+    std::array<Slot, capacity> slots;
+    std::atomic<size_t> enqueuePosition { 0 };
+    size_t dequeuePosition = 0;
+    std::atomic<bool> overflowed { false };
+};
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <array>
+
+/**
+ * @brief Compile-time description of every plugin parameter
+ *
+ * One row per parameter, in the same order as ParameterTable::Id. The table
+ * generates the APVTS layout, so a parameter's position in the table is also
+ * its index in AudioProcessor::getParameters(): code that has an Id never
+ * needs a string lookup. Handles resolves the raw value pointers once, into
+ * a contiguous array indexed by Id, and the editor builds its controls and
+ * attachments from the same rows.
+ *
+ * To add a parameter: add an Id, add its row below, and use it.
+ */
+namespace ParameterTable
+{
+    //==============================================================================
+    enum class Id : int
+    {
+        gain,
+        oversampling,
+        offlineOversampling,
+        oversamplingFilter,
+        convolutionLatency,
+        limiterLookahead,
+        limiterCeiling
+    };
+
+    constexpr int numParameters = 7;
+
+    enum class Kind
+    {
+        continuous,
+        choice
+    };
+
+    enum class EditorControl
+    {
+        none,
+        rotary
+    };
+
+    struct Descriptor
+    {
+        Id identifier;
+        const char* id;          // state/automation ID, never change once shipped
+        const char* name;
+        Kind kind;
+
+        // continuous parameters
+        float minimum, maximum, step, skew, defaultValue;
+        const char* unitSuffix;
+        double smoothingSeconds; // realtime ramp length; 0 = applied immediately
+
+        // choice parameters (defaultValue is the default index)
+        const char* const* choices;
+        int numChoices;
+
+        bool automatable;
+        bool changesLatency;     // reallocates and re-reports latency, so it's applied on the message thread
+        EditorControl editorControl;
+    };
+
+    //==============================================================================
+    constexpr Descriptor continuous(Id identifier, const char* id, const char* name,
+                                    float minimum, float maximum, float step, float skew, float defaultValue,
+                                    const char* unitSuffix, double smoothingSeconds, EditorControl control)
+    {
+        return { identifier, id, name, Kind::continuous,
+                 minimum, maximum, step, skew, defaultValue, unitSuffix, smoothingSeconds,
+                 nullptr, 0, true, false, control };
+    }
+
+    template <size_t numChoices>
+    constexpr Descriptor choice(Id identifier, const char* id, const char* name,
+                                const char* const (&choices)[numChoices], int defaultIndex, bool changesLatency)
+    {
+        // Choices that change latency reallocate, so they're never automatable
+        return { identifier, id, name, Kind::choice,
+                 0.0f, static_cast<float>(numChoices - 1), 1.0f, 1.0f, static_cast<float>(defaultIndex), "", 0.0,
+                 choices, static_cast<int>(numChoices), ! changesLatency, changesLatency, EditorControl::none };
+    }
+
+    inline constexpr const char* oversamplingFactorNames[] = { "Off", "2x", "4x", "8x" };
+    inline constexpr const char* oversamplingFilterNames[] = { "IIR (Low Latency)", "FIR (Linear Phase)" };
+    inline constexpr const char* convolutionLatencyNames[] = { "Zero Latency", "Lowest CPU" };
+    inline constexpr const char* limiterLookaheadNames[] = { "Off", "1 ms", "2 ms", "5 ms", "10 ms" };
+    inline constexpr double limiterLookaheadMilliseconds[] = { 0.0, 1.0, 2.0, 5.0, 10.0 };
+
+    inline constexpr std::array<Descriptor, numParameters> descriptors {{
+        continuous(Id::gain, "gain", "Gain", -60.0f, 12.0f, 0.1f, 1.0f, 0.0f, " dB", 0.05, EditorControl::rotary),
+
+        // Oversampling for the nonlinear section of the chain
+        choice(Id::oversampling, "oversampling", "Oversampling", oversamplingFactorNames, 0, true),
+        choice(Id::offlineOversampling, "offlineOversampling", "Offline Oversampling", oversamplingFactorNames, 0, true),
+        choice(Id::oversamplingFilter, "oversamplingFilter", "Oversampling Filter", oversamplingFilterNames, 0, true),
+
+        // Partitioning of the IR convolution stage (see ConvolutionStage)
+        choice(Id::convolutionLatency, "convolutionLatency", "Convolution Latency", convolutionLatencyNames, 0, true),
+
+        // Look-ahead peak limiter at the end of the gain stage; Off = no limiter, no latency
+        choice(Id::limiterLookahead, "limiterLookahead", "Limiter Look-ahead", limiterLookaheadNames, 0, true),
+        continuous(Id::limiterCeiling, "limiterCeiling", "Limiter Ceiling", -12.0f, 0.0f, 0.1f, 1.0f, -0.3f, " dB", 0.0, EditorControl::rotary),
+    }};
+
+    //==============================================================================
+    constexpr int indexOf(Id identifier) noexcept                 { return static_cast<int>(identifier); }
+    constexpr const Descriptor& get(Id identifier) noexcept       { return descriptors[static_cast<size_t>(identifier)]; }
+
+    constexpr bool isValidIndex(int parameterIndex) noexcept      { return juce::isPositiveAndBelow(parameterIndex, numParameters); }
+
+    constexpr bool rowsMatchIds() noexcept
+    {
+        for (size_t i = 0; i < descriptors.size(); ++i)
+            if (descriptors[i].identifier != static_cast<Id>(i))
+                return false;
+
+        return true;
+    }
+
+    static_assert(rowsMatchIds(), "every row must sit at the position of its Id");
+
+    //==============================================================================
+    /** Builds the APVTS layout, one parameter per row, in table order. */
+    juce::AudioProcessorValueTreeState::ParameterLayout createLayout();
+
+    /** The value range of a row. */
+    juce::NormalisableRange<float> makeRange(const Descriptor& descriptor);
+
+    //==============================================================================
+    /** Raw value pointers and parameter objects, indexed by Id. */
+    class Handles
+    {
+    public:
+        /** Resolves every row once; call from the processor constructor. */
+        void resolve(juce::AudioProcessorValueTreeState& apvts);
+
+        float load(Id identifier) const noexcept
+        {
+            return values[static_cast<size_t>(identifier)]->load(std::memory_order_relaxed);
+        }
+
+        int loadIndex(Id identifier) const noexcept { return juce::roundToInt(load(identifier)); }
+
+        juce::RangedAudioParameter& getParameter(Id identifier) const noexcept
+        {
+            return *parameters[static_cast<size_t>(identifier)];
+        }
+
+    private:
+        std::array<std::atomic<float>*, numParameters> values {};
+        std::array<juce::RangedAudioParameter*, numParameters> parameters {};
+    };
+}
@@ -1,6 +1,9 @@
 #pragma once
 
 #include <juce_audio_processors/juce_audio_processors.h>
+#if PLUGIN_USE_OPENGL
+ #include <juce_opengl/juce_opengl.h>
+#endif
 #include "PluginProcessor.h"
 
 /**
@@ -9,7 +12,8 @@
  * This class provides the user interface for the plugin,
  * displaying controls and visualizations.
  */
-class AudioPluginEditor : public juce::AudioProcessorEditor
+class AudioPluginEditor : public juce::AudioProcessorEditor,
+                          private juce::Timer
 {
 public:
     AudioPluginEditor(AudioPluginProcessor&);
@@ -18,15 +22,74 @@ public:
     //==============================================================================
     void paint(juce::Graphics&) override;
     void resized() override;
+    void visibilityChanged() override;
+    void parentHierarchyChanged() override;
+    void mouseDown(const juce::MouseEvent& event) override;
+
+    //==============================================================================
+    // Repaint Throttling
+    // Editor-driven repaints go through requestRepaint() and are coalesced
+    // into at most one repaint per frame.
+    static constexpr int defaultFrameRateHz = 30;
+
+    void setFrameRate(int framesPerSecond);
+    int getFrameRate() const noexcept { return frameRateHz; }
+    void requestRepaint() noexcept { pendingRepaintArea = getLocalBounds(); }
+    void requestRepaint(juce::Rectangle<int> area) noexcept { pendingRepaintArea = pendingRepaintArea.getUnion(area); }
 
 private:
+    //==============================================================================
+    void timerCallback() override;
+    void updateTimer();
+    void renderBackground();
+    void updateMeters();
+    void paintMeters(juce::Graphics& g) const;
+    void updateProfilerText();
+    void showImpulseResponseMenu();
+    void chooseImpulseResponse();
+
     // Reference to the processor
     AudioPluginProcessor& audioProcessor;
 
-    // Example: Gain slider
-    juce::Slider gainSlider;
-    juce::Label gainLabel;
-    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> gainAttachment;
+    // One rotary control per ParameterTable row with EditorControl::rotary
+    struct ParameterControl
+    {
+        juce::Slider slider;
+        juce::Label label;
+        std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> attachment;
+        int parameterIndex = 0; // ParameterTable index
+    };
+
+    void showMidiLearnMenu(const ParameterControl& control);
+
+    std::vector<std::unique_ptr<ParameterControl>> parameterControls;
+
+    // Static layer (background, title, footer), rendered on the first paint after resized()
+    juce::Image backgroundCache;
+
+    int frameRateHz = defaultFrameRateHz;
+    juce::Rectangle<int> pendingRepaintArea;
+
+    // Output meters, polled from the processor once per frame
+    juce::Rectangle<int> meterBounds;
+    std::array<float, LevelMeters::maxChannels> meterPeaks {};
+    std::array<float, LevelMeters::maxChannels> meterRms {};
+    int numMeterChannels = 0;
+    float peakDecayPerFrame = 1.0f;
+
+    // Collapsible CPU panel, refreshed a few times a second while open
+    juce::TextButton profilerToggle { "CPU" };
+    juce::Label profilerLabel;
+    BlockProfiler::Snapshot lastProfilerSnapshot;
+    int framesUntilProfilerUpdate = 0;
+
+    // Convolution IR: load or clear from a file chooser
+    juce::TextButton impulseButton { "IR" };
+    std::unique_ptr<juce::FileChooser> impulseChooser;
+
+#if PLUGIN_USE_OPENGL
+    juce::OpenGLContext openGLContext;
+#endif
 
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AudioPluginEditor)
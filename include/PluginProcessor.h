@@ -2,6 +2,19 @@
 
 #include <juce_audio_processors/juce_audio_processors.h>
 #include <juce_dsp/juce_dsp.h>
+#include "GainStage.h"
+#include "LookaheadLimiter.h"
+#include "StateSnapshot.h"
+#include "ParameterEventQueue.h"
+#include "LevelMeters.h"
+#include "BlockProfiler.h"
+#include "DspArena.h"
+#include "ParameterTable.h"
+#include "ConvolutionStage.h"
+#include "WorkerPool.h"
+#include "PresetBank.h"
+#include "MidiControlMap.h"
+#include "InputSanitiser.h"
 
 /**
  * @brief Main audio processor for the plugin
@@ -9,7 +22,10 @@
  * This class handles all audio processing, parameter management,
  * and state persistence for the plugin.
  */
-class AudioPluginProcessor : public juce::AudioProcessor
+class AudioPluginProcessor : public juce::AudioProcessor,
+                             private juce::AudioProcessorParameter::Listener,
+                             private juce::AsyncUpdater,
+                             private juce::Timer
 {
 public:
     //==============================================================================
@@ -18,10 +34,14 @@ public:
 
     //==============================================================================
     // Audio Processing
+    static constexpr int maxNumChannels = 64;
+
     void prepareToPlay(double sampleRate, int samplesPerBlock) override;
     void releaseResources() override;
     bool isBusesLayoutSupported(const BusesLayout& layouts) const override;
     void processBlock(juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock(juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    bool supportsDoublePrecisionProcessing() const override;
 
     //==============================================================================
     // Editor
@@ -44,6 +64,14 @@ public:
     const juce::String getProgramName(int index) override;
     void changeProgramName(int index, const juce::String& newName) override;
 
+    // Message thread. Programs come from a memory-mapped bank (see PresetBank.h);
+    // without one the plugin has a single unnamed program. Returns false and
+    // keeps the current bank if the file isn't a valid bank.
+    bool loadPresetBank(const juce::File& bankFile);
+
+    /** The current parameter values as a bank entry, for building banks with PresetBank::write(). */
+    PresetBank::Program captureProgram(const juce::String& name);
+
     //==============================================================================
     // State Persistence
     void getStateInformation(juce::MemoryBlock& destData) override;
@@ -53,20 +81,250 @@ public:
     // Parameter Management
     juce::AudioProcessorValueTreeState& getValueTreeState() { return apvts; }
 
+    //==============================================================================
+    // Metering
+    LevelMeters& getLevelMeters() noexcept { return levelMeters; }
+
+    // Blocks whose input held NaN, Inf or subnormal samples (zeroed before processing)
+    juce::uint32 getNumRepairedInputBlocks() const noexcept { return inputSanitiser.getNumRepairedBlocks(); }
+
+    //==============================================================================
+    // Profiling
+    // Every processBlock call is timed into this instance's histogram. Setting
+    // PLUGIN_PROFILE_LOG_DIR in the environment starts a CSV log on prepare.
+    BlockProfiler& getBlockProfiler() noexcept { return blockProfiler; }
+
+    void startProfilerLog(const juce::File& csvFile, int intervalMilliseconds = 1000);
+    void stopProfilerLog();
+
+    //==============================================================================
+    // Convolution
+    // Message thread. Returns at once: the IR is read, resampled and
+    // partitioned in the background and swapped in without blocking
+    // processBlock; latency and tail follow once it arrives, then onLoaded is
+    // called on the message thread. The stage is bypassed until an IR is loaded.
+    void loadImpulseResponse(const juce::File& file, std::function<void(bool loaded)> onLoaded = {});
+    void loadImpulseResponse(juce::AudioBuffer<float>&& impulseResponse, double impulseSampleRate,
+                             std::function<void(bool loaded)> onLoaded = {});
+    void clearImpulseResponse();
+    bool hasImpulseResponse() const noexcept { return convolution.isActive(); }
+
+    //==============================================================================
+    // Multithreading
+    // Opt-in: spreads independent per-block work (convolution channel pairs)
+    // over realtime worker threads that join the host's audio workgroup.
+    // 0, the default, keeps all processing on the host's audio thread.
+    void setNumWorkerThreads(int numThreads); // message thread
+    int getNumWorkerThreads() const noexcept { return workerPool != nullptr ? workerPool->getNumWorkers() : 0; }
+    const WorkerPool* getWorkerPool() const noexcept { return workerPool.get(); }
+
+    void audioWorkgroupContextChanged(const juce::AudioWorkgroup& workgroup) override;
+
+    //==============================================================================
+    // MIDI Control
+    // With PLUGIN_MIDI_CONTROL, mapped CCs move parameters at their sample
+    // positions, split like sample-accurate automation; with MIDI input,
+    // program changes select bank programs. The parameters themselves follow
+    // on the message thread, so hosts and the editor see the CC values.
+    MidiControlMap& getMidiControlMap() noexcept { return midiControlMap; }
+
+    // Message thread; call after changing the map. The sync timer only runs
+    // while a CC is mapped or being learnt, or a bank is loaded.
+    void updateMidiSync();
+
+    //==============================================================================
+    // Automation
+    enum class AutomationMode
+    {
+        perBlock,      // Parameter read once per block, smoothed with a fixed ramp
+        sampleAccurate // Parameter interpolated per sample across each block
+    };
+
+    void setAutomationMode(AutomationMode newMode) noexcept;
+    AutomationMode getAutomationMode() const noexcept;
+
+    //==============================================================================
+    // Processing Profiles
+    // Chosen in prepareToPlay from isNonRealtime(): live playback gets the
+    // cheapest settings, offline renders trade CPU for quality.
+    struct ProcessingProfile
+    {
+        int oversamplingFactorIndex = 0; // 0 = off, 1 = 2x, 2 = 4x, 3 = 8x
+        double rampDurationSeconds = 0.05; // gain smoothing from ParameterTable, doubled offline
+        bool doublePrecisionInternals = false;
+    };
+
+    const ProcessingProfile& getActiveProfile() const noexcept { return activeProfile; }
+
 private:
     //==============================================================================
     // Parameter Layout
     static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
 
+    //==============================================================================
+    // Processing Core
+    // Both processBlock overloads forward here so float and double hosts share
+    // one code path without converting buffers. Host blocks are processed in
+    // sub-blocks of at most preparedSpec.maximumBlockSize samples.
+    static constexpr int minimumPreparedBlockSize = 1024;
+    static constexpr int tinyBlockSize = 16; // at or below this, skip per-block bookkeeping
+
+    template <typename SampleType>
+    void processInSubBlocks(juce::AudioBuffer<SampleType>& buffer, juce::MidiBuffer& midiMessages);
+
+    template <typename SampleType>
+    void processBlockImpl(juce::AudioBuffer<SampleType>& buffer, juce::MidiBuffer& midiMessages,
+                          int startSample, int numSamples, int midiStartSample);
+
+    // DSP modules instantiated once per sample type
+    template <typename SampleType>
+    struct DspChain
+    {
+        GainStage<SampleType> gain;
+        LookaheadLimiter<SampleType> limiter; // memory from the arena; disabled at zero look-ahead
+        std::unique_ptr<juce::dsp::Oversampling<SampleType>> oversampling; // nullptr when off
+        GainKernels::MeasureKernel<SampleType> measure = nullptr;           // set in prepareToPlay
+    };
+
+    template <typename SampleType>
+    DspChain<SampleType>& getChain() noexcept;
+
+    template <typename SampleType>
+    void processConvolution(const juce::dsp::AudioBlock<SampleType>& block) noexcept;
+    void runConvolution(const juce::dsp::AudioBlock<float>& block) noexcept; // on the worker pool when enabled
+
+    template <typename SampleType>
+    void measureOutput(const DspChain<SampleType>& chain, const juce::dsp::AudioBlock<SampleType>& block) noexcept;
+
+    //==============================================================================
+    // State Snapshot
+    // Any parameter change bumps the generation so state capture can tell
+    // whether the audio thread's last snapshot is still current.
+    void parameterValueChanged(int parameterIndex, float newValue) override;
+    void parameterGestureChanged(int parameterIndex, bool gestureIsStarting) override;
+    void publishStateSnapshot() noexcept;
+
+    //==============================================================================
+    // Parameter Events
+    // Changes are queued by the parameter listener and drained at the top of
+    // processBlock, so only parameters that moved are touched.
+    void collectParameterEvents(int numSamples) noexcept;
+    void addBlockEvent(const ParameterEvent& event) noexcept;
+    int findNextEventOffset(size_t afterIndex, int parameterIndex, int numSamples) const noexcept;
+
+    template <typename SampleType>
+    void applyParameterEvent(DspChain<SampleType>& chain, const ParameterEvent& event, int rampSamples) noexcept;
+
+    //==============================================================================
+    // MIDI Events
+    // CCs and program changes in the block become block events next to the
+    // automation, so they take the same segment splitting. Values are then
+    // handed to the message thread, which sets the parameters without
+    // queueing them back to processBlock a second time.
+    static constexpr int midiSyncIntervalMs = 30;
+
+    void collectMidiEvents(const juce::MidiBuffer& midiMessages, int midiStartSample, int numSamples) noexcept;
+    void applyMidiValue(int parameterIndex, float value, int sampleOffset) noexcept;
+    void applyMidiProgramChange(int program, int sampleOffset) noexcept;
+    void timerCallback() override; // pushes MIDI-driven values to the parameters
+    bool needsMidiSync() const noexcept;
+
+    //==============================================================================
+    // Oversampling and Convolution
+    // Oversamplers and convolution engines are allocated off the audio thread:
+    // in prepareToPlay, or via handleAsyncUpdate under the callback lock when
+    // the settings change.
+    ProcessingProfile makeProcessingProfile() const;
+    void processWithDoubleInternals(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages,
+                                    int startSample, int numSamples);
+    void prepareOversampling();
+    void prepareConvolution(bool forceRebuild);
+    void prepareLimiter(); // look-ahead from the parameter; no allocation
+    int updateLatencyAndTail(); // returns the latency to report
+    void impulseResponseChanged();
+    void handleAsyncUpdate() override;
+
+    template <typename SampleType>
+    void prepareChainOversampling(DspChain<SampleType>& chain, int factorIndex,
+                                  typename juce::dsp::Oversampling<SampleType>::FilterType filterType);
+
+    //==============================================================================
+    // Scratch Memory
+    // Sizes and carves every scratch buffer out of the arena. JUCE modules that
+    // allocate internally (Oversampling) keep their own memory.
+    void prepareArena(const juce::dsp::ProcessSpec& spec);
+
     //==============================================================================
     // Member Variables
     juce::AudioProcessorValueTreeState apvts;
 
-    // Example: Gain parameter
-    std::atomic<float>* gainParameter = nullptr;
+    // Raw parameter values, indexed by ParameterTable::Id
+    ParameterTable::Handles parameterHandles;
+
+    juce::dsp::ProcessSpec preparedSpec { 0.0, 0, 0 };
+
+    ProcessingProfile activeProfile;
+
+    // Scratch memory, allocated once per prepareToPlay (see prepareArena)
+    DspArena arena;
+    juce::AudioBuffer<double> doubleInternalsBuffer; // float hosts in the offline profile; refers into arena
+    juce::AudioBuffer<float> convolutionBuffer;      // double chain's float copy for the convolution; refers into arena
 
     // Example: DSP processors
-    juce::dsp::Gain<float> gain;
+    DspChain<float> floatChain;
+    DspChain<double> doubleChain;
+
+    // Float only, shared by both chains (the double chain converts around it)
+    ConvolutionStage convolution;
+
+    // Workers may wait at most this share of a block's duration before the
+    // pool falls back to the audio thread alone
+    static constexpr double workerDeadlineFraction = 0.25;
+
+    static constexpr double maxLimiterLookaheadMs = 10.0; // the last limiterLookahead choice
+    int limiterLookaheadSamples = 0;
+
+    std::unique_ptr<PresetBank> presetBank; // swapped under the callback lock
+    std::atomic<int> currentProgram { 0 };
+
+    MidiControlMap midiControlMap;
+    std::array<std::atomic<float>, ParameterTable::numParameters> midiPendingValues; // NaN when nothing is pending
+    std::atomic<bool> midiProgramChanged { false };
+    std::atomic<int> midiEchoIndex { -1 }; // parameter the timer is setting, already applied by processBlock
+    bool midiSyncAllowed = false;          // between prepareToPlay and releaseResources
+
+    std::unique_ptr<WorkerPool> workerPool; // swapped under the callback lock
+    double workerDeadlineTicksPerSample = 0.0;
+    juce::SpinLock workgroupLock;
+    juce::AudioWorkgroup audioWorkgroup;
+
+    std::atomic<AutomationMode> automationMode { AutomationMode::sampleAccurate };
+    int minimumRampSamples = 1;
+
+    StateSnapshot stateSnapshot;
+    std::atomic<juce::uint32> parameterGeneration { 1 };
+    juce::uint32 lastPublishedGeneration = 0;
+
+    ParameterEventQueue parameterEvents;
+    std::array<ParameterEvent, ParameterEventQueue::capacity> blockEvents;
+    size_t numBlockEvents = 0;
+    std::atomic<bool> parameterRefreshPending { true };
+    juce::NormalisableRange<float> gainRange;
+    juce::NormalisableRange<float> ceilingRange;
+
+    InputSanitiser inputSanitiser;
+
+    // Silence handling: the chain is skipped once the input has been silent
+    // for longer than the tail the chain can still produce
+    std::atomic<double> tailLengthSeconds { 0.0 };
+    int tailLengthSamples = 0;
+    juce::int64 silentInputSamples = 0;
+
+    LevelMeters levelMeters;
+    BlockProfiler blockProfiler;
+    std::unique_ptr<BlockProfilerLog> profilerLog;
+    const int instanceNumber;
+    static_assert(LevelMeters::maxChannels >= maxNumChannels, "every supported channel needs a meter");
 
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AudioPluginProcessor)
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief Read-only bank of programs, memory-mapped from one file
+ *
+ * Layout (little endian, offsets from the start of the file):
+ *
+ *     uint32  magic            'MVPB'
+ *     uint16  version          currentVersion
+ *     uint16  numPrograms
+ *     numPrograms x {
+ *         uint32  nameOffset
+ *         uint32  nameLength   (UTF-8, not terminated)
+ *         uint32  stateOffset
+ *         uint32  stateSize    (a StateFormat binary state)
+ *     }
+ *     names and states, at the offsets above
+ *
+ * open() maps the file rather than reading it, checks every offset against
+ * the mapping, and decodes each program's state once into a row of
+ * normalised values indexed like AudioProcessor::getParameters(). Switching
+ * programs then only walks one precomputed row; names are read straight from
+ * the mapping when asked for.
+ */
+class PresetBank
+{
+public:
+    static constexpr juce::uint32 magic = 0x4250564d; // "MVPB" when read as bytes
+    static constexpr juce::uint16 currentVersion = 1;
+    static constexpr int maxPrograms = 1024;
+
+    struct Program
+    {
+        juce::String name;
+        juce::MemoryBlock state; // StateFormat::write() output
+    };
+
+    //==============================================================================
+    /** Message thread. Returns nullptr if the file is missing or malformed. */
+    static std::unique_ptr<PresetBank> open(const juce::File& file, const juce::AudioProcessor& processor);
+
+    /** Writes a bank file, replacing any existing one only once the new file is complete. */
+    static bool write(const juce::File& file, const juce::Array<Program>& programs);
+
+    //==============================================================================
+    int getNumPrograms() const noexcept { return static_cast<int>(names.size()); }
+    bool isValidProgram(int index) const noexcept { return juce::isPositiveAndBelow(index, getNumPrograms()); }
+
+    juce::String getProgramName(int index) const;
+
+    /**
+     * Normalised values for a program, indexed like getParameters(). Parameters
+     * the program doesn't store are NaN, meaning "keep the current value".
+     */
+    const float* getNormalisedValues(int index) const noexcept
+    {
+        return values.data() + static_cast<size_t>(index) * static_cast<size_t>(numParameters);
+    }
+
+    int getNumParameters() const noexcept { return numParameters; }
+
+private:
+    //==============================================================================
+    PresetBank() = default;
+
+    struct Name
+    {
+        const char* text; // points into the mapping
+        int length;
+    };
+
+    std::unique_ptr<juce::MemoryMappedFile> mapping;
+    std::vector<Name> names;
+    std::vector<float> values; // one row of numParameters per program
+    int numParameters = 0;
+
+    JUCE_DECLARE_NON_COPYABLE(PresetBank)
+};
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+/**
+ * @brief Debug/CI check that processBlock never allocates or blocks
+ *
+ * Built with -DPLUGIN_REALTIME_CHECKS=ON, the global allocation operators
+ * (and on Linux pthread_mutex_lock, pthread_cond_wait, pthread_cond_timedwait,
+ * nanosleep and usleep) are replaced with versions that abort with a stack
+ * trace when called on a thread that is inside a ScopedRealtimeScope. processBlock opens one for
+ * its whole duration, so any violation in the chain, however deep, is caught
+ * the first time it happens.
+ *
+ * The hooks replace process-wide symbols, so they are meant for the
+ * benchmark/stress harness and debug builds only, never for release plugins.
+ * In normal builds ScopedRealtimeScope is an empty object.
+ */
+namespace RealtimeGuard
+{
+   #if PLUGIN_REALTIME_CHECKS
+    constexpr bool isEnabled() noexcept { return true; }
+
+    /** Marks the current thread as realtime until destroyed. Nests. */
+    class ScopedRealtimeScope
+    {
+    public:
+        ScopedRealtimeScope() noexcept;
+        ~ScopedRealtimeScope() noexcept;
+
+    private:
+        bool wasActive;
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedRealtimeScope)
+    };
+
+    /** Temporarily lifts the check, e.g. for code that is allowed to block during a test. */
+    class ScopedRealtimeExemption
+    {
+    public:
+        ScopedRealtimeExemption() noexcept;
+        ~ScopedRealtimeExemption() noexcept;
+
+    private:
+        bool wasActive;
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedRealtimeExemption)
+    };
+
+    /** True if the calling thread is inside a realtime scope. */
+    bool isActive() noexcept;
+
+    /** Prints what happened with a stack trace and aborts. */
+    [[noreturn]] void reportViolation(const char* operation) noexcept;
+   #else
+    constexpr bool isEnabled() noexcept { return false; }
+
+    struct ScopedRealtimeScope
+    {
+        ScopedRealtimeScope() noexcept {}
+    };
+
+    struct ScopedRealtimeExemption
+    {
+        ScopedRealtimeExemption() noexcept {}
+    };
+
+    inline bool isActive() noexcept { return false; }
+   #endif
+}
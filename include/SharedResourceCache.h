@@ -0,0 +1,87 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <map>
+#include <memory>
+#include <tuple>
+#include <typeindex>
+
+/**
+ * @brief Process-wide cache of immutable resources shared between instances
+ *
+ * Large read-only data (decoded and resampled IRs, lookup tables) is built
+ * once per process and handed out as shared_ptr<const T>, keyed by its type,
+ * a hash of the content it was made from and the sample rate it was made
+ * for. The cache only holds weak references: a resource lives exactly as
+ * long as some instance uses it, so closing a session frees everything.
+ *
+ * Hold it through juce::SharedResourcePointer<SharedResourceCache> so all
+ * instances in the process see the same cache. Any non-realtime thread:
+ * acquire() locks and may build the resource.
+ */
+class SharedResourceCache
+{
+public:
+    struct Key
+    {
+        juce::uint64 contentHash = 0;
+        double sampleRate = 0.0; // 0 for rate-independent resources
+    };
+
+    //==============================================================================
+    /**
+     * Returns the cached resource for the key, or stores and returns what
+     * create() builds (a unique_ptr or shared_ptr to Resource; nullptr on
+     * failure is passed through). create() runs outside the lock, so two
+     * instances missing at once may both build; the first stored copy wins.
+     */
+    template <typename Resource, typename Create>
+    std::shared_ptr<const Resource> acquire(const Key& key, Create&& create)
+    {
+        const EntryKey entryKey { std::type_index(typeid(Resource)), key.contentHash, key.sampleRate };
+
+        if (auto existing = find(entryKey))
+            return std::static_pointer_cast<const Resource>(existing);
+
+        std::shared_ptr<const Resource> created { create() };
+
+        if (created == nullptr)
+            return nullptr;
+
+        return std::static_pointer_cast<const Resource>(store(entryKey, created));
+    }
+
+    /** The cached resource for the key, or nullptr; never builds, so it is cheap enough for prepare(). */
+    template <typename Resource>
+    std::shared_ptr<const Resource> get(const Key& key)
+    {
+        return std::static_pointer_cast<const Resource>(find({ std::type_index(typeid(Resource)), key.contentHash, key.sampleRate }));
+    }
+
+    /** Resources currently alive; for diagnostics. */
+    int getNumResources() const;
+
+    /** 64-bit FNV-1a; chain calls through the seed for data in several pieces. */
+    static juce::uint64 hashBytes(const void* data, size_t numBytes,
+                                  juce::uint64 seed = 0xcbf29ce484222325ull) noexcept;
+
+private:
+    //==============================================================================
+    struct EntryKey
+    {
+        std::type_index type;
+        juce::uint64 contentHash;
+        double sampleRate;
+
+        bool operator<(const EntryKey& other) const noexcept
+        {
+            return std::tie(type, contentHash, sampleRate) < std::tie(other.type, other.contentHash, other.sampleRate);
+        }
+    };
+
+    std::shared_ptr<const void> find(const EntryKey& key);
+    std::shared_ptr<const void> store(const EntryKey& key, std::shared_ptr<const void> resource);
+
+    juce::CriticalSection lock;
+    std::map<EntryKey, std::weak_ptr<const void>> entries;
+};
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <juce_audio_processors/juce_audio_processors.h>
+#include "MidiControlMap.h"
+
+/**
+ * @brief Compact binary plugin state
+ *
+ * Layout (little endian):
+ *
+ *     uint32  magic            'MVST'
+ *     uint16  version          currentVersion
+ *     uint16  numParameters
+ *     numParameters x {
+ *         uint8   idLength
+ *         char    id[idLength]  (UTF-8, not terminated)
+ *         float32 value         (denormalised, i.e. in the parameter's own units)
+ *     }
+ *
+ * optionally followed by the MIDI CC assignments:
+ *
+ *     uint32  tag              'MVMM'
+ *     uint16  numMappings
+ *     numMappings x {
+ *         uint8   midiChannel   (1..16, or 0 for omni)
+ *         uint8   controller
+ *         uint8   idLength
+ *         char    id[idLength]
+ *     }
+ *
+ * Values and assignments are matched back to parameters by ID, so adding,
+ * removing or reordering parameters doesn't break older states. Unknown IDs
+ * and non-finite values are ignored, and parameters missing from the state
+ * keep their current value. Readers skip trailing data they don't know, so
+ * states with assignments still load in builds from before them.
+ */
+namespace StateFormat
+{
+    //==============================================================================
+    constexpr juce::uint32 magic = 0x5453564d; // "MVST" when read as bytes
+    constexpr juce::uint16 currentVersion = 1;
+    constexpr juce::uint32 midiMappingsTag = 0x4d4d564d; // "MVMM" when read as bytes
+
+    /** True if the data starts with a binary state header this build can read. */
+    bool isBinaryState(const void* data, int sizeInBytes) noexcept;
+
+    /**
+     * Writes every ranged parameter of the processor to destData, replacing
+     * its contents, and the assignments of midiMappings if it has any.
+     */
+    void write(const juce::AudioProcessor& processor, juce::MemoryBlock& destData,
+               const MidiControlMap* midiMappings = nullptr);
+
+    /**
+     * Like write(), but takes the normalised values from normalisedValues,
+     * indexed like processor.getParameters(), instead of the live parameters.
+     */
+    void write(const juce::AudioProcessor& processor, const float* normalisedValues, juce::MemoryBlock& destData,
+               const MidiControlMap* midiMappings = nullptr);
+
+    /**
+     * Restores parameters from a binary state and, if midiMappings is given,
+     * replaces its assignments with the stored ones (none if the state has
+     * none). Returns false, having changed nothing, if the data isn't one or
+     * is truncated; nothing is set until the whole state has decoded.
+     */
+    bool read(juce::AudioProcessor& processor, const void* data, int sizeInBytes,
+              MidiControlMap* midiMappings = nullptr);
+
+    /**
+     * Decodes a binary state into normalised values indexed like
+     * processor.getParameters(), without touching the parameters. Entries for
+     * parameters missing from the state, or stored as NaN or Inf, are left as
+     * they were, and on failure none are written. MIDI assignments are skipped.
+     */
+    bool readNormalisedValues(const juce::AudioProcessor& processor, const void* data, int sizeInBytes,
+                              float* normalisedValues);
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <array>
+#include <atomic>
+
+/**
+ * @brief Seqlock-protected copy of the normalised parameter values
+ *
+ * The audio thread is the only writer: it publishes the values it is about to
+ * process at the top of every block, which never waits. Readers (state
+ * capture on the message or autosave thread) copy the values out and retry if
+ * a write overlapped, so neither side ever takes a lock.
+ *
+ * Each snapshot carries the parameter generation it was taken at. Readers
+ * pass the current generation and the read fails if a parameter has changed
+ * since, so a stale snapshot is never mistaken for the current state.
+ */
+class StateSnapshot
+{
+public:
+    static constexpr int maxValues = 256;
+
+    //==============================================================================
+    /** Audio thread only. getValue(i) is called for i in [0, numValues). */
+    template <typename ValueGetter>
+    void publish(juce::uint32 generation, int numValues, ValueGetter&& getValue) noexcept
+    {
+        numValues = juce::jmin(numValues, maxValues);
+
+        const auto seq = sequence.load(std::memory_order_relaxed);
+        sequence.store(seq + 1, std::memory_order_relaxed); // odd: write in progress
+        std::atomic_thread_fence(std::memory_order_release);
+
+        for (int i = 0; i < numValues; ++i)
+            values[static_cast<size_t>(i)].store(getValue(i), std::memory_order_relaxed);
+
+        snapshotGeneration.store(generation, std::memory_order_relaxed);
+        snapshotSize.store(numValues, std::memory_order_relaxed);
+        sequence.store(seq + 2, std::memory_order_release);
+    }
+
+    /** Copies a consistent snapshot into dest if one exists for the given generation. */
+    bool read(float* dest, int numValues, juce::uint32 currentGeneration) const noexcept
+    {
+        for (int attempt = 0; attempt < maxReadAttempts; ++attempt)
+        {
+            const auto before = sequence.load(std::memory_order_acquire);
+
+            if (before == 0)
+                return false; // nothing published yet
+
+            if ((before & 1) != 0)
+                continue;
+
+            const auto generation = snapshotGeneration.load(std::memory_order_relaxed);
+            const auto size = snapshotSize.load(std::memory_order_relaxed);
+
+            for (int i = 0; i < juce::jmin(numValues, size); ++i)
+                dest[i] = values[static_cast<size_t>(i)].load(std::memory_order_relaxed);
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            if (sequence.load(std::memory_order_relaxed) == before)
+                return generation == currentGeneration && size >= numValues;
+        }
+
+        return false;
+    }
+
+private:
+    //==============================================================================
+    static constexpr int maxReadAttempts = 16;
+
+    std::atomic<juce::uint32> sequence { 0 };
+    std::atomic<juce::uint32> snapshotGeneration { 0 };
+    std::atomic<int> snapshotSize { 0 };
+    std::array<std::atomic<float>, maxValues> values {};
+};
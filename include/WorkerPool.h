@@ -0,0 +1,120 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_core/juce_core.h>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief Realtime worker threads that share a block's work with the audio thread
+ *
+ * run() splits one job into numTasks independent tasks (e.g. one per channel
+ * pair) and returns once all have run. The audio thread claims tasks itself
+ * alongside the workers, from a shared lock-free claim counter, so tasks no
+ * worker has picked up yet are simply done by the caller and a worker that's
+ * late to wake costs nothing. Each task is started exactly once: whoever wins
+ * its start flag runs it. If the wait passes the deadline, the caller takes
+ * back tasks a worker claimed but hasn't started (preempted between the two),
+ * so from then on it only waits for tasks actually running on a worker.
+ *
+ * If that wait exceeds the block deadline too often (workers preempted, cores
+ * oversubscribed), the pool falls back to running every task on the calling
+ * thread for a while before trying the workers again.
+ *
+ * Workers join the host's audio workgroup when one is set (macOS), register
+ * with MMCSS as "Pro Audio" (Windows), and are woken with a semaphore that
+ * doesn't lock a mutex on the signalling side.
+ */
+class WorkerPool
+{
+public:
+    using Task = void (*)(void* context, int taskIndex) noexcept;
+
+    static constexpr int maxWorkers = 15;
+    static constexpr int maxTasks = 64;             // more than this run on the caller
+    static constexpr int missesBeforeFallback = 4;  // within missWindowRuns runs
+    static constexpr int missWindowRuns = 64;
+    static constexpr int fallbackRuns = 1024;       // inline runs before the workers are retried
+
+    struct Stats
+    {
+        juce::uint64 parallelRuns = 0;
+        juce::uint64 inlineRuns = 0;     // during fallback
+        juce::uint64 deadlineMisses = 0;
+        juce::uint64 tasksOnWorkers = 0;
+        juce::uint64 tasksOnCaller = 0;
+    };
+
+    //==============================================================================
+    /** Message thread. Starts the worker threads (clamped to 1..maxWorkers). */
+    explicit WorkerPool(int numWorkers);
+
+    /** Message thread. Stops the workers; run() must not be in progress. */
+    ~WorkerPool();
+
+    int getNumWorkers() const noexcept { return static_cast<int>(workers.size()); }
+
+    /** Any thread. Workers join it before their next task; an invalid workgroup leaves it. */
+    void setWorkgroup(const juce::AudioWorkgroup& newWorkgroup);
+
+    //==============================================================================
+    /**
+     * Audio thread. Runs task(context, i) for every i in [0, numTasks) and
+     * returns when all have finished. deadlineTicks (high-resolution ticks)
+     * bounds how long the caller waits for workers to start what they
+     * claimed; after that it runs those tasks itself.
+     */
+    void run(int numTasks, Task task, void* context, juce::int64 deadlineTicks) noexcept;
+
+    bool isFallingBack() const noexcept { return fallbackRunsLeft > 0; }
+
+    /** Any thread; counters are updated relaxed and may be a run apart. */
+    Stats getStats() const noexcept;
+
+private:
+    //==============================================================================
+    class Worker;
+    class Semaphore;
+
+    int runClaimedTasks() noexcept;   // returns the number of tasks run
+    int runUnstartedTasks() noexcept; // caller only, past the deadline
+    bool tryRunTask(int index) noexcept;
+    void workerLoop(Worker& worker);
+    void updateWorkgroup(Worker& worker);
+
+    // Task count in the high half, next unclaimed index in the low half: one
+    // fetch_add claims an index and tells the claimer which job it belongs to.
+    // Between jobs the count is zero, so late claims never match a task.
+    std::atomic<juce::uint64> claimWord { 0 };
+
+    // Job number in the upper bits, task count in the low byte, published
+    // before the claim word. A task's start flag holds the number of the last
+    // job it was started in, so a stale claim from an earlier job never runs.
+    std::atomic<juce::uint64> jobWord { 0 };
+    std::array<std::atomic<juce::uint64>, maxTasks> taskStarted {};
+    juce::uint64 jobNumber = 0; // audio thread only
+
+    std::atomic<int> remainingTasks { 0 };
+    std::atomic<Task> jobTask { nullptr };
+    std::atomic<void*> jobContext { nullptr };
+
+    std::unique_ptr<Semaphore> wake;
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::atomic<bool> shouldExit { false };
+
+    juce::SpinLock workgroupLock;
+    juce::AudioWorkgroup workgroup;
+    std::atomic<int> workgroupGeneration { 0 };
+
+    // Audio thread only
+    int fallbackRunsLeft = 0;
+    int runsInWindow = 0;
+    int missesInWindow = 0;
+
+    std::atomic<juce::uint64> parallelRuns { 0 }, inlineRuns { 0 }, deadlineMisses { 0 };
+    std::atomic<juce::uint64> tasksOnWorkers { 0 }, tasksOnCaller { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE(WorkerPool)
+};
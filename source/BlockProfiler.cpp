@@ -0,0 +1,120 @@
+#include "../include/BlockProfiler.h"
+
+//==============================================================================
+BlockProfiler::Snapshot BlockProfiler::getSnapshot() const noexcept
+{
+    Snapshot snapshot;
+
+    // Count last, so a block that lands mid-copy is at worst counted in the
+    // next snapshot rather than having no bucket
+    for (size_t i = 0; i < buckets.size(); ++i)
+        snapshot.buckets[i] = buckets[i].load(std::memory_order_relaxed);
+
+    snapshot.totalNanos = totalNanos.load(std::memory_order_relaxed);
+    snapshot.totalAudioNanos = totalAudioNanos.load(std::memory_order_relaxed);
+    snapshot.maxNanos = maxNanos.load(std::memory_order_relaxed);
+    snapshot.numBlocks = numBlocks.load(std::memory_order_relaxed);
+    return snapshot;
+}
+
+juce::uint64 BlockProfiler::getBucketUpperNanos(int bucketIndex) noexcept
+{
+    if (bucketIndex <= 0)
+        return juce::uint64(1) << firstOctave;
+
+    const auto octave = firstOctave + (bucketIndex - 1) / bucketsPerOctave;
+    const auto subBucket = (bucketIndex - 1) % bucketsPerOctave;
+    return static_cast<juce::uint64>(5 + subBucket) << (octave - 2);
+}
+
+BlockProfiler::Stats BlockProfiler::computeStats(const Snapshot& current, const Snapshot& previous) noexcept
+{
+    Stats stats;
+    stats.maxMicros = static_cast<double>(current.maxNanos) * 1.0e-3;
+
+    std::array<juce::uint64, numBuckets> window {};
+    juce::uint64 windowBlocks = 0;
+
+    for (size_t i = 0; i < window.size(); ++i)
+    {
+        window[i] = current.buckets[i] >= previous.buckets[i] ? current.buckets[i] - previous.buckets[i] : 0;
+        windowBlocks += window[i];
+    }
+
+    if (windowBlocks == 0)
+        return stats;
+
+    const auto windowNanos = static_cast<double>(current.totalNanos - juce::jmin(current.totalNanos, previous.totalNanos));
+    const auto windowAudioNanos = static_cast<double>(current.totalAudioNanos
+                                                      - juce::jmin(current.totalAudioNanos, previous.totalAudioNanos));
+
+    stats.numBlocks = windowBlocks;
+    stats.averageMicros = windowNanos * 1.0e-3 / static_cast<double>(windowBlocks);
+    stats.budgetPercent = windowAudioNanos > 0.0 ? 100.0 * windowNanos / windowAudioNanos : 0.0;
+
+    // Smallest bucket that covers 99 % of the window
+    const auto target = (windowBlocks * 99 + 99) / 100;
+    juce::uint64 cumulative = 0;
+
+    for (int i = 0; i < numBuckets; ++i)
+    {
+        cumulative += window[static_cast<size_t>(i)];
+
+        if (cumulative >= target)
+        {
+            stats.p99Micros = static_cast<double>(getBucketUpperNanos(i)) * 1.0e-3;
+            break;
+        }
+    }
+
+    // The top bucket is open-ended, and no bucket edge is worse than the maximum seen
+    if (stats.maxMicros > 0.0)
+        stats.p99Micros = juce::jmin(stats.p99Micros, stats.maxMicros);
+
+    return stats;
+}
+
+//==============================================================================
+BlockProfilerLog::BlockProfilerLog(const BlockProfiler& profilerToLog, const juce::File& csvFile, int intervalMilliseconds)
+    : juce::Thread("Block profiler log"),
+      profiler(profilerToLog),
+      file(csvFile),
+      intervalMs(juce::jmax(100, intervalMilliseconds))
+{
+    startThread(juce::Thread::Priority::background);
+}
+
+BlockProfilerLog::~BlockProfilerLog()
+{
+    stopThread(intervalMs + 1000);
+}
+
+void BlockProfilerLog::run()
+{
+    juce::FileOutputStream stream(file);
+
+    if (! stream.openedOk())
+        return;
+
+    if (stream.getPosition() == 0)
+        stream << "time,blocks,avg_us,p99_us,max_us,budget_pct\n";
+
+    auto previous = profiler.getSnapshot();
+
+    while (! threadShouldExit())
+    {
+        wait(intervalMs);
+
+        const auto current = profiler.getSnapshot();
+        const auto stats = BlockProfiler::computeStats(current, previous);
+        previous = current;
+
+        stream << juce::Time::getCurrentTime().toISO8601(true) << ','
+               << juce::String(static_cast<juce::int64>(stats.numBlocks)) << ','
+               << juce::String(stats.averageMicros, 2) << ','
+               << juce::String(stats.p99Micros, 2) << ','
+               << juce::String(stats.maxMicros, 2) << ','
+               << juce::String(stats.budgetPercent, 3) << '\n';
+        stream.flush();
+    }
+}
@@ -0,0 +1,316 @@
+#include "../include/ConvolutionStage.h"
+
+namespace
+{
+    constexpr int maxImpulseChannels = 2; // engines are loaded with Stereo::yes
+}
+
+//==============================================================================
+void ConvolutionStage::prepare(const juce::dsp::ProcessSpec& spec, LatencyMode newMode)
+{
+    if (! queue.has_value())
+        queue.emplace();
+
+    preparedSpec = spec;
+    mode = newMode;
+
+    // Partitioning is fixed at construction, so a mode change means new engines
+    engines.clear();
+
+    for (juce::uint32 firstChannel = 0; firstChannel < spec.numChannels; firstChannel += 2)
+    {
+        std::unique_ptr<juce::dsp::Convolution> engine;
+
+        if (mode == LatencyMode::zeroLatency)
+            engine = std::make_unique<juce::dsp::Convolution>(juce::dsp::Convolution::NonUniform { zeroLatencyHeadSamples },
+                                                              **queue);
+        else
+            engine = std::make_unique<juce::dsp::Convolution>(juce::dsp::Convolution::Latency { lowCpuLatencySamples },
+                                                              **queue);
+
+        engine->prepare({ spec.sampleRate, spec.maximumBlockSize, juce::jmin(2u, spec.numChannels - firstChannel) });
+        engines.push_back(std::move(engine));
+    }
+
+    // Nothing in flight: reload now if the IR is at this rate already (here or
+    // in another instance), otherwise have the loader resample it. A load in
+    // flight is resampled again in publish() if it finishes at the wrong rate.
+    if (sourceImpulse != nullptr && publishedGeneration == requestedGeneration)
+    {
+        auto cached = sourceImpulse->sampleRate == spec.sampleRate
+                          ? sourceImpulse
+                          : resources->get<ImpulseResponse>({ impulseHash, spec.sampleRate });
+
+        if (cached != nullptr)
+        {
+            preparedImpulse = std::move(cached);
+            loadIntoEngines();
+        }
+        else
+        {
+            LoadRequest request;
+            request.source = sourceImpulse;
+            request.sourceHash = impulseHash;
+            requestLoad(std::move(request), {});
+        }
+    }
+}
+
+void ConvolutionStage::reset() noexcept
+{
+    for (auto& engine : engines)
+        engine->reset();
+}
+
+//==============================================================================
+void ConvolutionStage::loadImpulseResponse(const juce::File& file, LoadCallback onLoaded)
+{
+    LoadRequest request;
+    request.file = file;
+    requestLoad(std::move(request), std::move(onLoaded));
+}
+
+void ConvolutionStage::loadImpulseResponse(juce::AudioBuffer<float>&& impulseResponse, double sampleRateOfImpulse,
+                                           LoadCallback onLoaded)
+{
+    jassert(impulseResponse.getNumSamples() > 0 && sampleRateOfImpulse > 0.0);
+
+    LoadRequest request;
+    request.buffer = std::make_shared<juce::AudioBuffer<float>>(std::move(impulseResponse));
+    request.bufferSampleRate = sampleRateOfImpulse;
+    requestLoad(std::move(request), std::move(onLoaded));
+}
+
+void ConvolutionStage::clearImpulseResponse()
+{
+    active.store(false, std::memory_order_release);
+
+    // Drops any load still in flight
+    publishedGeneration = ++requestedGeneration;
+
+    // The last instance to let go frees the shared copies
+    sourceImpulse.reset();
+    preparedImpulse.reset();
+    impulseHash = 0;
+}
+
+//==============================================================================
+void ConvolutionStage::requestLoad(LoadRequest request, LoadCallback onLoaded)
+{
+    if (! loader.has_value())
+        loader.emplace();
+
+    request.targetRate = preparedSpec.sampleRate;
+    request.generation = ++requestedGeneration;
+
+    std::weak_ptr<ConvolutionStage*> token = lifetimeToken;
+
+    (*loader)->pool.addJob([request = std::move(request), onLoaded = std::move(onLoaded), token]
+    {
+        // Held here rather than through the stage, which may be gone by the time this runs
+        juce::SharedResourcePointer<SharedResourceCache> cache;
+        auto result = runLoad(request, *cache);
+
+        juce::MessageManager::callAsync([result = std::move(result), onLoaded, token]() mutable
+        {
+            if (auto stage = token.lock())
+                (*stage)->publish(std::move(result), std::move(onLoaded));
+        });
+    });
+}
+
+void ConvolutionStage::publish(LoadResult result, LoadCallback onLoaded)
+{
+    if (result.generation != requestedGeneration)
+        return;
+
+    if (result.prepared == nullptr)
+    {
+        publishedGeneration = result.generation;
+
+        if (onLoaded != nullptr)
+            onLoaded(false);
+
+        return;
+    }
+
+    // Prepared at another rate while this was loading: resample the decoded source again
+    if (preparedSpec.sampleRate > 0.0 && result.prepared->sampleRate != preparedSpec.sampleRate)
+    {
+        LoadRequest request;
+        request.source = std::move(result.source);
+        request.sourceHash = result.sourceHash;
+        requestLoad(std::move(request), std::move(onLoaded));
+        return;
+    }
+
+    publishedGeneration = result.generation;
+    sourceImpulse = std::move(result.source);
+    preparedImpulse = std::move(result.prepared);
+    impulseHash = result.sourceHash;
+
+    // While inactive process() isn't called, so stale history can be cleared
+    if (! isActive())
+        reset();
+
+    loadIntoEngines();
+    active.store(true, std::memory_order_release);
+
+    if (onImpulseChanged != nullptr)
+        onImpulseChanged();
+
+    if (onLoaded != nullptr)
+        onLoaded(true);
+}
+
+//==============================================================================
+ConvolutionStage::LoadResult ConvolutionStage::runLoad(const LoadRequest& request, SharedResourceCache& cache)
+{
+    LoadResult result;
+    result.generation = request.generation;
+
+    if (request.source != nullptr)
+    {
+        result.source = request.source;
+        result.sourceHash = request.sourceHash;
+    }
+    else if (request.buffer != nullptr)
+    {
+        auto& buffer = *request.buffer;
+        const auto numChannels = juce::jmin(maxImpulseChannels, buffer.getNumChannels());
+        const auto sampleRateOfImpulse = request.bufferSampleRate;
+        auto hash = SharedResourceCache::hashBytes(&sampleRateOfImpulse, sizeof(sampleRateOfImpulse));
+
+        for (int ch = 0; ch < numChannels; ++ch)
+            hash = SharedResourceCache::hashBytes(buffer.getReadPointer(ch),
+                                                  sizeof(float) * static_cast<size_t>(buffer.getNumSamples()), hash);
+
+        result.sourceHash = hash;
+        result.source = cache.acquire<ImpulseResponse>({ hash, 0.0 }, [&]
+        {
+            auto impulse = std::make_unique<ImpulseResponse>();
+            impulse->samples = std::move(buffer);
+            impulse->samples.setSize(numChannels, impulse->samples.getNumSamples(), true);
+            impulse->sampleRate = sampleRateOfImpulse;
+            return impulse;
+        });
+    }
+    else
+    {
+        result.source = decodeFile(request.file, result.sourceHash, cache);
+    }
+
+    if (result.source != nullptr)
+        result.prepared = resample(result.source, result.sourceHash, request.targetRate, cache);
+
+    return result;
+}
+
+std::shared_ptr<const ConvolutionStage::ImpulseResponse> ConvolutionStage::decodeFile(const juce::File& file, juce::uint64& hash,
+                                                                                      SharedResourceCache& cache)
+{
+    // Keyed by the file's bytes, so the same IR under another name is still shared
+    juce::MemoryBlock fileData;
+
+    if (! file.loadFileAsData(fileData) || fileData.isEmpty())
+        return nullptr;
+
+    hash = SharedResourceCache::hashBytes(fileData.getData(), fileData.getSize());
+
+    return cache.acquire<ImpulseResponse>({ hash, 0.0 }, [&fileData]() -> std::unique_ptr<ImpulseResponse>
+    {
+        juce::AudioFormatManager formatManager;
+        formatManager.registerBasicFormats();
+
+        const std::unique_ptr<juce::AudioFormatReader> reader(
+            formatManager.createReaderFor(std::make_unique<juce::MemoryInputStream>(fileData, false)));
+
+        if (reader == nullptr || reader->lengthInSamples <= 0 || reader->sampleRate <= 0.0
+            || reader->lengthInSamples > std::numeric_limits<int>::max())
+            return nullptr;
+
+        auto impulse = std::make_unique<ImpulseResponse>();
+        impulse->sampleRate = reader->sampleRate;
+        impulse->samples.setSize(juce::jmin(maxImpulseChannels, static_cast<int>(reader->numChannels)),
+                                 static_cast<int>(reader->lengthInSamples));
+        reader->read(&impulse->samples, 0, impulse->samples.getNumSamples(), 0, true, true);
+        return impulse;
+    });
+}
+
+std::shared_ptr<const ConvolutionStage::ImpulseResponse> ConvolutionStage::resample(const std::shared_ptr<const ImpulseResponse>& source,
+                                                                                    juce::uint64 hash, double targetRate,
+                                                                                    SharedResourceCache& cache)
+{
+    if (targetRate <= 0.0 || source->sampleRate == targetRate)
+        return source;
+
+    // Resampled once per rate for the whole process, rather than by every engine
+    return cache.acquire<ImpulseResponse>({ hash, targetRate }, [&source, targetRate]
+    {
+        const auto ratio = source->sampleRate / targetRate;
+        const auto numChannels = source->samples.getNumChannels();
+        const auto numSamples = static_cast<int>(std::ceil(static_cast<double>(source->samples.getNumSamples()) / ratio));
+
+        juce::AudioBuffer<float> input(source->samples);
+        juce::MemoryAudioSource memorySource(input, false);
+        juce::ResamplingAudioSource resampler(&memorySource, false, numChannels);
+        resampler.setResamplingRatio(ratio);
+        resampler.prepareToPlay(numSamples, targetRate);
+
+        auto impulse = std::make_unique<ImpulseResponse>();
+        impulse->sampleRate = targetRate;
+        impulse->samples.setSize(numChannels, numSamples);
+        resampler.getNextAudioBlock(juce::AudioSourceChannelInfo(impulse->samples));
+        return impulse;
+    });
+}
+
+void ConvolutionStage::loadIntoEngines()
+{
+    if (preparedImpulse == nullptr)
+        return;
+
+    // Each engine gets a transient copy at its own rate, so it only partitions;
+    // that runs on the message queue thread
+    for (auto& engine : engines)
+    {
+        juce::AudioBuffer<float> copy(preparedImpulse->samples);
+        engine->loadImpulseResponse(std::move(copy), preparedImpulse->sampleRate,
+                                    juce::dsp::Convolution::Stereo::yes,
+                                    juce::dsp::Convolution::Trim::no,
+                                    juce::dsp::Convolution::Normalise::yes);
+    }
+}
+
+//==============================================================================
+int ConvolutionStage::getLatencySamples() const noexcept
+{
+    return engines.empty() ? 0 : engines.front()->getLatency();
+}
+
+int ConvolutionStage::getTailSamples() const noexcept
+{
+    return preparedImpulse != nullptr ? preparedImpulse->samples.getNumSamples() : 0;
+}
+
+//==============================================================================
+void ConvolutionStage::process(const juce::dsp::AudioBlock<float>& block) noexcept
+{
+    const auto numPairs = getNumPairs(block.getNumChannels());
+
+    for (int pair = 0; pair < numPairs; ++pair)
+        processPair(pair, block);
+}
+
+void ConvolutionStage::processPair(int pairIndex, const juce::dsp::AudioBlock<float>& block) noexcept
+{
+    const auto firstChannel = static_cast<size_t>(pairIndex) * 2;
+    auto pairBlock = block.getSubsetChannelBlock(firstChannel, juce::jmin(size_t(2), block.getNumChannels() - firstChannel));
+    engines[static_cast<size_t>(pairIndex)]->process(juce::dsp::ProcessContextReplacing<float>(pairBlock));
+}
+
+int ConvolutionStage::getNumPairs(size_t numChannels) const noexcept
+{
+    return static_cast<int>(juce::jmin(engines.size(), (numChannels + 1) / 2));
+}
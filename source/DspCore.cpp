@@ -0,0 +1,142 @@
+#include <juce_core/juce_core.h>
+#include "../include/DspCore.h"
+
+// DSP_CORE_HAS_* are defined by CMake for each PLUGIN_CPU_VARIANTS entry. A
+// universal macOS build compiles every variant into both slices, so each is
+// only referenced on the architecture it was built for.
+#if DSP_CORE_HAS_AVX2 && JUCE_INTEL
+ #define DSP_CORE_USE_AVX2 1
+#endif
+
+#if DSP_CORE_HAS_AVX512 && JUCE_INTEL
+ #define DSP_CORE_USE_AVX512 1
+#endif
+
+#if DSP_CORE_HAS_APPLE_ARM64 && JUCE_MAC && JUCE_ARM && JUCE_64BIT
+ #define DSP_CORE_USE_APPLE_ARM64 1
+#endif
+
+namespace DspCore
+{
+    namespace baseline     { extern const VariantKernels kernels; }
+   #if DSP_CORE_USE_AVX2
+    namespace avx2         { extern const VariantKernels kernels; }
+   #endif
+   #if DSP_CORE_USE_AVX512
+    namespace avx512       { extern const VariantKernels kernels; }
+   #endif
+   #if DSP_CORE_USE_APPLE_ARM64
+    namespace apple_arm64  { extern const VariantKernels kernels; }
+   #endif
+
+namespace
+{
+    const VariantKernels& selectKernels(Variant variant) noexcept
+    {
+        if (! isSupported(variant))
+            return baseline::kernels;
+
+        switch (variant)
+        {
+           #if DSP_CORE_USE_AVX2
+            case Variant::avx2:         return avx2::kernels;
+           #endif
+           #if DSP_CORE_USE_AVX512
+            case Variant::avx512:       return avx512::kernels;
+           #endif
+           #if DSP_CORE_USE_APPLE_ARM64
+            case Variant::appleSilicon: return apple_arm64::kernels;
+           #endif
+            default: break;
+        }
+
+        return baseline::kernels;
+    }
+}
+
+//==============================================================================
+bool isBuilt(Variant variant) noexcept
+{
+    switch (variant)
+    {
+        case Variant::baseline:     return true;
+       #if DSP_CORE_USE_AVX2
+        case Variant::avx2:         return true;
+       #endif
+       #if DSP_CORE_USE_AVX512
+        case Variant::avx512:       return true;
+       #endif
+       #if DSP_CORE_USE_APPLE_ARM64
+        case Variant::appleSilicon: return true;
+       #endif
+        default: break;
+    }
+
+    return false;
+}
+
+bool isSupported(Variant variant) noexcept
+{
+    if (! isBuilt(variant))
+        return false;
+
+    switch (variant)
+    {
+       #if JUCE_INTEL
+        case Variant::avx2:
+            return juce::SystemStats::hasAVX2() && juce::SystemStats::hasFMA3();
+
+        case Variant::avx512:
+            return juce::SystemStats::hasAVX512F() && juce::SystemStats::hasAVX512VL()
+                && juce::SystemStats::hasAVX512DQ() && juce::SystemStats::hasAVX512BW()
+                && juce::SystemStats::hasAVX512CD() && juce::SystemStats::hasAVX2()
+                && juce::SystemStats::hasFMA3();
+       #endif
+
+        // Every arm64 Mac is at least an M1
+        case Variant::baseline:
+        case Variant::appleSilicon:
+        default:
+            return true;
+    }
+}
+
+Variant getBestVariant() noexcept
+{
+    static const auto best = []
+    {
+        for (auto candidate : { Variant::avx512, Variant::avx2, Variant::appleSilicon })
+            if (isSupported(candidate))
+                return candidate;
+
+        return Variant::baseline;
+    }();
+
+    return best;
+}
+
+const char* getName(Variant variant) noexcept
+{
+    switch (variant)
+    {
+        case Variant::baseline:     return "baseline";
+        case Variant::avx2:         return "avx2";
+        case Variant::avx512:       return "avx512";
+        case Variant::appleSilicon: return "apple_arm64";
+    }
+
+    return "unknown";
+}
+
+template <>
+const Kernels<float>& getKernels<float>(Variant variant) noexcept
+{
+    return selectKernels(variant).floatKernels;
+}
+
+template <>
+const Kernels<double>& getKernels<double>(Variant variant) noexcept
+{
+    return selectKernels(variant).doubleKernels;
+}
+}
@@ -0,0 +1,62 @@
+// Compiled once as the baseline and once per PLUGIN_CPU_VARIANTS entry, through
+// a generated wrapper that defines DSP_CORE_VARIANT and carries that target's
+// ISA flags (see CMakeLists.txt).
+//
+// Everything in this file must either live in the variant's namespace or be
+// inlined into it: an out-of-line copy of a shared inline function compiled
+// with AVX2 could be the one the linker keeps for the whole binary. That is
+// why FastMath is forcedinline, why nothing here calls juce helpers, and why
+// CMake only applies the ISA flags in optimised configurations.
+#ifndef DSP_CORE_VARIANT
+ #define DSP_CORE_VARIANT baseline
+#endif
+
+#include "../include/DspCore.h"
+#include "../include/FastMath.h"
+
+#include <cmath>
+#include <limits>
+
+namespace DspCore
+{
+namespace DSP_CORE_VARIANT
+{
+namespace
+{
+    //==============================================================================
+    template <typename SampleType>
+    void fillExp2Ramp(SampleType* destination, int numSamples, SampleType startLog2, SampleType stepLog2) noexcept
+    {
+        for (int i = 0; i < numSamples; ++i)
+            destination[i] = FastMath::exp2(startLog2 + stepLog2 * static_cast<SampleType>(i + 1));
+    }
+
+    // Branch-free so every variant vectorises it
+    template <typename SampleType>
+    bool scanForRepair(const SampleType* data, size_t numSamples, SampleType& peak) noexcept
+    {
+        auto channelPeak = peak;
+        int flags = 0;
+
+        for (size_t i = 0; i < numSamples; ++i)
+        {
+            const auto magnitude = std::abs(data[i]);
+            flags |= static_cast<int>(! (magnitude <= std::numeric_limits<SampleType>::max()));
+            flags |= static_cast<int>(magnitude < std::numeric_limits<SampleType>::min()) & static_cast<int>(magnitude != SampleType(0));
+            channelPeak = magnitude > channelPeak ? magnitude : channelPeak;
+        }
+
+        peak = channelPeak;
+        return flags != 0;
+    }
+}
+
+    //==============================================================================
+    extern const VariantKernels kernels;
+
+    const VariantKernels kernels {
+        { &fillExp2Ramp<float>, &scanForRepair<float> },
+        { &fillExp2Ramp<double>, &scanForRepair<double> }
+    };
+}
+}
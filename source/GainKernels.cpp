@@ -0,0 +1,528 @@
+#include <juce_core/juce_core.h>
+#include "../include/GainKernels.h"
+
+#if JUCE_INTEL
+ #include <immintrin.h>
+ #if JUCE_GCC || JUCE_CLANG
+  #define GAIN_KERNEL_TARGET(isa) __attribute__((target(isa)))
+ #else
+  #define GAIN_KERNEL_TARGET(isa)
+ #endif
+#endif
+
+#if JUCE_ARM && (defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64))
+ #include <arm_neon.h>
+ #define GAIN_KERNELS_HAVE_NEON 1
+ #if defined(__aarch64__) || defined(_M_ARM64)
+  #define GAIN_KERNELS_HAVE_NEON_DOUBLE 1
+ #endif
+#endif
+
+namespace GainKernels
+{
+namespace
+{
+    //==============================================================================
+    // Scalar reference, also used for the tails of the vector kernels.
+    // The gain is always derived from the absolute index so every kernel
+    // produces the same ramp regardless of vector width.
+    template <typename SampleType>
+    void rampScalarRange(SampleType* first, SampleType* second, int begin, int end,
+                         SampleType start, SampleType step) noexcept
+    {
+        if (second != nullptr)
+        {
+            for (int i = begin; i < end; ++i)
+            {
+                const auto g = start + step * static_cast<SampleType>(i + 1);
+                first[i] *= g;
+                second[i] *= g;
+            }
+        }
+        else
+        {
+            for (int i = begin; i < end; ++i)
+                first[i] *= start + step * static_cast<SampleType>(i + 1);
+        }
+    }
+
+    template <typename SampleType>
+    void rampScalar(SampleType* first, SampleType* second, int numSamples,
+                    SampleType start, SampleType step) noexcept
+    {
+        rampScalarRange(first, second, 0, numSamples, start, step);
+    }
+
+    template <typename SampleType>
+    void measureScalarRange(const SampleType* data, int begin, int end,
+                            SampleType& peak, SampleType& sumOfSquares) noexcept
+    {
+        for (int i = begin; i < end; ++i)
+        {
+            const auto x = data[i];
+            peak = juce::jmax(peak, std::abs(x));
+            sumOfSquares += x * x;
+        }
+    }
+
+    template <typename SampleType>
+    void measureScalar(const SampleType* data, int numSamples, SampleType& peak, SampleType& sumOfSquares) noexcept
+    {
+        peak = SampleType(0);
+        sumOfSquares = SampleType(0);
+        measureScalarRange(data, 0, numSamples, peak, sumOfSquares);
+    }
+
+#if JUCE_INTEL
+    //==============================================================================
+    GAIN_KERNEL_TARGET("sse2")
+    void rampSse2(float* first, float* second, int numSamples, float start, float step) noexcept
+    {
+        const auto vStart = _mm_set1_ps(start);
+        const auto vStep = _mm_set1_ps(step);
+        const auto vWidth = _mm_set1_ps(4.0f);
+        auto index = _mm_setr_ps(1.0f, 2.0f, 3.0f, 4.0f);
+        int i = 0;
+
+        for (; i + 4 <= numSamples; i += 4)
+        {
+            const auto g = _mm_add_ps(vStart, _mm_mul_ps(vStep, index));
+            _mm_storeu_ps(first + i, _mm_mul_ps(_mm_loadu_ps(first + i), g));
+
+            if (second != nullptr)
+                _mm_storeu_ps(second + i, _mm_mul_ps(_mm_loadu_ps(second + i), g));
+
+            index = _mm_add_ps(index, vWidth);
+        }
+
+        rampScalarRange(first, second, i, numSamples, start, step);
+    }
+
+    GAIN_KERNEL_TARGET("sse2")
+    void rampSse2(double* first, double* second, int numSamples, double start, double step) noexcept
+    {
+        const auto vStart = _mm_set1_pd(start);
+        const auto vStep = _mm_set1_pd(step);
+        const auto vWidth = _mm_set1_pd(2.0);
+        auto index = _mm_setr_pd(1.0, 2.0);
+        int i = 0;
+
+        for (; i + 2 <= numSamples; i += 2)
+        {
+            const auto g = _mm_add_pd(vStart, _mm_mul_pd(vStep, index));
+            _mm_storeu_pd(first + i, _mm_mul_pd(_mm_loadu_pd(first + i), g));
+
+            if (second != nullptr)
+                _mm_storeu_pd(second + i, _mm_mul_pd(_mm_loadu_pd(second + i), g));
+
+            index = _mm_add_pd(index, vWidth);
+        }
+
+        rampScalarRange(first, second, i, numSamples, start, step);
+    }
+
+    //==============================================================================
+    GAIN_KERNEL_TARGET("avx2")
+    void rampAvx2(float* first, float* second, int numSamples, float start, float step) noexcept
+    {
+        const auto vStart = _mm256_set1_ps(start);
+        const auto vStep = _mm256_set1_ps(step);
+        const auto vWidth = _mm256_set1_ps(8.0f);
+        auto index = _mm256_setr_ps(1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f);
+        int i = 0;
+
+        for (; i + 8 <= numSamples; i += 8)
+        {
+            const auto g = _mm256_add_ps(vStart, _mm256_mul_ps(vStep, index));
+            _mm256_storeu_ps(first + i, _mm256_mul_ps(_mm256_loadu_ps(first + i), g));
+
+            if (second != nullptr)
+                _mm256_storeu_ps(second + i, _mm256_mul_ps(_mm256_loadu_ps(second + i), g));
+
+            index = _mm256_add_ps(index, vWidth);
+        }
+
+        _mm256_zeroupper(); // avoid the AVX/SSE transition penalty in the scalar tail
+        rampScalarRange(first, second, i, numSamples, start, step);
+    }
+
+    GAIN_KERNEL_TARGET("avx2")
+    void rampAvx2(double* first, double* second, int numSamples, double start, double step) noexcept
+    {
+        const auto vStart = _mm256_set1_pd(start);
+        const auto vStep = _mm256_set1_pd(step);
+        const auto vWidth = _mm256_set1_pd(4.0);
+        auto index = _mm256_setr_pd(1.0, 2.0, 3.0, 4.0);
+        int i = 0;
+
+        for (; i + 4 <= numSamples; i += 4)
+        {
+            const auto g = _mm256_add_pd(vStart, _mm256_mul_pd(vStep, index));
+            _mm256_storeu_pd(first + i, _mm256_mul_pd(_mm256_loadu_pd(first + i), g));
+
+            if (second != nullptr)
+                _mm256_storeu_pd(second + i, _mm256_mul_pd(_mm256_loadu_pd(second + i), g));
+
+            index = _mm256_add_pd(index, vWidth);
+        }
+
+        _mm256_zeroupper(); // avoid the AVX/SSE transition penalty in the scalar tail
+        rampScalarRange(first, second, i, numSamples, start, step);
+    }
+
+    //==============================================================================
+    GAIN_KERNEL_TARGET("avx512f")
+    void rampAvx512(float* first, float* second, int numSamples, float start, float step) noexcept
+    {
+        const auto vStart = _mm512_set1_ps(start);
+        const auto vStep = _mm512_set1_ps(step);
+        const auto vWidth = _mm512_set1_ps(16.0f);
+        auto index = _mm512_setr_ps(1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f,
+                                    9.0f, 10.0f, 11.0f, 12.0f, 13.0f, 14.0f, 15.0f, 16.0f);
+        int i = 0;
+
+        for (; i + 16 <= numSamples; i += 16)
+        {
+            const auto g = _mm512_add_ps(vStart, _mm512_mul_ps(vStep, index));
+            _mm512_storeu_ps(first + i, _mm512_mul_ps(_mm512_loadu_ps(first + i), g));
+
+            if (second != nullptr)
+                _mm512_storeu_ps(second + i, _mm512_mul_ps(_mm512_loadu_ps(second + i), g));
+
+            index = _mm512_add_ps(index, vWidth);
+        }
+
+        _mm256_zeroupper(); // avoid the AVX/SSE transition penalty in the scalar tail
+        rampScalarRange(first, second, i, numSamples, start, step);
+    }
+
+    GAIN_KERNEL_TARGET("avx512f")
+    void rampAvx512(double* first, double* second, int numSamples, double start, double step) noexcept
+    {
+        const auto vStart = _mm512_set1_pd(start);
+        const auto vStep = _mm512_set1_pd(step);
+        const auto vWidth = _mm512_set1_pd(8.0);
+        auto index = _mm512_setr_pd(1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0);
+        int i = 0;
+
+        for (; i + 8 <= numSamples; i += 8)
+        {
+            const auto g = _mm512_add_pd(vStart, _mm512_mul_pd(vStep, index));
+            _mm512_storeu_pd(first + i, _mm512_mul_pd(_mm512_loadu_pd(first + i), g));
+
+            if (second != nullptr)
+                _mm512_storeu_pd(second + i, _mm512_mul_pd(_mm512_loadu_pd(second + i), g));
+
+            index = _mm512_add_pd(index, vWidth);
+        }
+
+        _mm256_zeroupper(); // avoid the AVX/SSE transition penalty in the scalar tail
+        rampScalarRange(first, second, i, numSamples, start, step);
+    }
+    //==============================================================================
+    GAIN_KERNEL_TARGET("sse2")
+    void measureSse2(const float* data, int numSamples, float& peak, float& sumOfSquares) noexcept
+    {
+        const auto signMask = _mm_set1_ps(-0.0f);
+        auto vPeak = _mm_setzero_ps();
+        auto vSum = _mm_setzero_ps();
+        int i = 0;
+
+        for (; i + 4 <= numSamples; i += 4)
+        {
+            const auto x = _mm_loadu_ps(data + i);
+            vPeak = _mm_max_ps(vPeak, _mm_andnot_ps(signMask, x));
+            vSum = _mm_add_ps(vSum, _mm_mul_ps(x, x));
+        }
+
+        alignas(16) float peaks[4], sums[4];
+        _mm_store_ps(peaks, vPeak);
+        _mm_store_ps(sums, vSum);
+
+        peak = juce::jmax(juce::jmax(peaks[0], peaks[1]), juce::jmax(peaks[2], peaks[3]));
+        sumOfSquares = (sums[0] + sums[1]) + (sums[2] + sums[3]);
+        measureScalarRange(data, i, numSamples, peak, sumOfSquares);
+    }
+
+    GAIN_KERNEL_TARGET("sse2")
+    void measureSse2(const double* data, int numSamples, double& peak, double& sumOfSquares) noexcept
+    {
+        const auto signMask = _mm_set1_pd(-0.0);
+        auto vPeak = _mm_setzero_pd();
+        auto vSum = _mm_setzero_pd();
+        int i = 0;
+
+        for (; i + 2 <= numSamples; i += 2)
+        {
+            const auto x = _mm_loadu_pd(data + i);
+            vPeak = _mm_max_pd(vPeak, _mm_andnot_pd(signMask, x));
+            vSum = _mm_add_pd(vSum, _mm_mul_pd(x, x));
+        }
+
+        alignas(16) double peaks[2], sums[2];
+        _mm_store_pd(peaks, vPeak);
+        _mm_store_pd(sums, vSum);
+
+        peak = juce::jmax(peaks[0], peaks[1]);
+        sumOfSquares = sums[0] + sums[1];
+        measureScalarRange(data, i, numSamples, peak, sumOfSquares);
+    }
+
+    GAIN_KERNEL_TARGET("avx2")
+    void measureAvx2(const float* data, int numSamples, float& peak, float& sumOfSquares) noexcept
+    {
+        const auto signMask = _mm256_set1_ps(-0.0f);
+        auto vPeak = _mm256_setzero_ps();
+        auto vSum = _mm256_setzero_ps();
+        int i = 0;
+
+        for (; i + 8 <= numSamples; i += 8)
+        {
+            const auto x = _mm256_loadu_ps(data + i);
+            vPeak = _mm256_max_ps(vPeak, _mm256_andnot_ps(signMask, x));
+            vSum = _mm256_add_ps(vSum, _mm256_mul_ps(x, x));
+        }
+
+        alignas(32) float peaks[8], sums[8];
+        _mm256_store_ps(peaks, vPeak);
+        _mm256_store_ps(sums, vSum);
+        _mm256_zeroupper();
+
+        peak = 0.0f;
+        sumOfSquares = 0.0f;
+
+        for (int lane = 0; lane < 8; ++lane)
+        {
+            peak = juce::jmax(peak, peaks[lane]);
+            sumOfSquares += sums[lane];
+        }
+
+        measureScalarRange(data, i, numSamples, peak, sumOfSquares);
+    }
+
+    GAIN_KERNEL_TARGET("avx2")
+    void measureAvx2(const double* data, int numSamples, double& peak, double& sumOfSquares) noexcept
+    {
+        const auto signMask = _mm256_set1_pd(-0.0);
+        auto vPeak = _mm256_setzero_pd();
+        auto vSum = _mm256_setzero_pd();
+        int i = 0;
+
+        for (; i + 4 <= numSamples; i += 4)
+        {
+            const auto x = _mm256_loadu_pd(data + i);
+            vPeak = _mm256_max_pd(vPeak, _mm256_andnot_pd(signMask, x));
+            vSum = _mm256_add_pd(vSum, _mm256_mul_pd(x, x));
+        }
+
+        alignas(32) double peaks[4], sums[4];
+        _mm256_store_pd(peaks, vPeak);
+        _mm256_store_pd(sums, vSum);
+        _mm256_zeroupper();
+
+        peak = juce::jmax(juce::jmax(peaks[0], peaks[1]), juce::jmax(peaks[2], peaks[3]));
+        sumOfSquares = (sums[0] + sums[1]) + (sums[2] + sums[3]);
+        measureScalarRange(data, i, numSamples, peak, sumOfSquares);
+    }
+#endif
+
+#if GAIN_KERNELS_HAVE_NEON
+    //==============================================================================
+    void rampNeon(float* first, float* second, int numSamples, float start, float step) noexcept
+    {
+        const auto vStart = vdupq_n_f32(start);
+        const auto vWidth = vdupq_n_f32(4.0f);
+        const float initialIndex[] = { 1.0f, 2.0f, 3.0f, 4.0f };
+        auto index = vld1q_f32(initialIndex);
+        int i = 0;
+
+        for (; i + 4 <= numSamples; i += 4)
+        {
+            const auto g = vaddq_f32(vStart, vmulq_n_f32(index, step));
+            vst1q_f32(first + i, vmulq_f32(vld1q_f32(first + i), g));
+
+            if (second != nullptr)
+                vst1q_f32(second + i, vmulq_f32(vld1q_f32(second + i), g));
+
+            index = vaddq_f32(index, vWidth);
+        }
+
+        rampScalarRange(first, second, i, numSamples, start, step);
+    }
+
+   #if GAIN_KERNELS_HAVE_NEON_DOUBLE
+    void rampNeon(double* first, double* second, int numSamples, double start, double step) noexcept
+    {
+        const auto vStart = vdupq_n_f64(start);
+        const auto vWidth = vdupq_n_f64(2.0);
+        const double initialIndex[] = { 1.0, 2.0 };
+        auto index = vld1q_f64(initialIndex);
+        int i = 0;
+
+        for (; i + 2 <= numSamples; i += 2)
+        {
+            const auto g = vaddq_f64(vStart, vmulq_n_f64(index, step));
+            vst1q_f64(first + i, vmulq_f64(vld1q_f64(first + i), g));
+
+            if (second != nullptr)
+                vst1q_f64(second + i, vmulq_f64(vld1q_f64(second + i), g));
+
+            index = vaddq_f64(index, vWidth);
+        }
+
+        rampScalarRange(first, second, i, numSamples, start, step);
+    }
+   #else
+    void rampNeon(double* first, double* second, int numSamples, double start, double step) noexcept
+    {
+        rampScalar(first, second, numSamples, start, step);
+    }
+   #endif
+
+    void measureNeon(const float* data, int numSamples, float& peak, float& sumOfSquares) noexcept
+    {
+        auto vPeak = vdupq_n_f32(0.0f);
+        auto vSum = vdupq_n_f32(0.0f);
+        int i = 0;
+
+        for (; i + 4 <= numSamples; i += 4)
+        {
+            const auto x = vld1q_f32(data + i);
+            vPeak = vmaxq_f32(vPeak, vabsq_f32(x));
+            vSum = vmlaq_f32(vSum, x, x);
+        }
+
+        float peaks[4], sums[4];
+        vst1q_f32(peaks, vPeak);
+        vst1q_f32(sums, vSum);
+
+        peak = juce::jmax(juce::jmax(peaks[0], peaks[1]), juce::jmax(peaks[2], peaks[3]));
+        sumOfSquares = (sums[0] + sums[1]) + (sums[2] + sums[3]);
+        measureScalarRange(data, i, numSamples, peak, sumOfSquares);
+    }
+
+    void measureNeon(const double* data, int numSamples, double& peak, double& sumOfSquares) noexcept
+    {
+        measureScalar(data, numSamples, peak, sumOfSquares);
+    }
+#endif
+
+    //==============================================================================
+    template <typename SampleType>
+    RampKernel<SampleType> selectRampKernel(InstructionSet instructionSet) noexcept
+    {
+        if (! isSupported(instructionSet))
+            return &rampScalar<SampleType>;
+
+        switch (instructionSet)
+        {
+           #if JUCE_INTEL
+            case InstructionSet::sse2:   return static_cast<RampKernel<SampleType>>(&rampSse2);
+            case InstructionSet::avx2:   return static_cast<RampKernel<SampleType>>(&rampAvx2);
+            case InstructionSet::avx512: return static_cast<RampKernel<SampleType>>(&rampAvx512);
+           #endif
+           #if GAIN_KERNELS_HAVE_NEON
+            case InstructionSet::neon:   return static_cast<RampKernel<SampleType>>(&rampNeon);
+           #endif
+            default: break;
+        }
+
+        return &rampScalar<SampleType>;
+    }
+
+    template <typename SampleType>
+    MeasureKernel<SampleType> selectMeasureKernel(InstructionSet instructionSet) noexcept
+    {
+        if (! isSupported(instructionSet))
+            return &measureScalar<SampleType>;
+
+        switch (instructionSet)
+        {
+           #if JUCE_INTEL
+            case InstructionSet::sse2:   return static_cast<MeasureKernel<SampleType>>(&measureSse2);
+            case InstructionSet::avx2:   // metering is memory bound; AVX-512 gains nothing over AVX2
+            case InstructionSet::avx512: return static_cast<MeasureKernel<SampleType>>(&measureAvx2);
+           #endif
+           #if GAIN_KERNELS_HAVE_NEON
+            case InstructionSet::neon:   return static_cast<MeasureKernel<SampleType>>(&measureNeon);
+           #endif
+            default: break;
+        }
+
+        return &measureScalar<SampleType>;
+    }
+}
+
+//==============================================================================
+bool isSupported(InstructionSet instructionSet) noexcept
+{
+    switch (instructionSet)
+    {
+        case InstructionSet::scalar: return true;
+       #if JUCE_INTEL
+        case InstructionSet::sse2:   return juce::SystemStats::hasSSE2();
+        case InstructionSet::avx2:   return juce::SystemStats::hasAVX2();
+        case InstructionSet::avx512: return juce::SystemStats::hasAVX512F();
+       #endif
+       #if GAIN_KERNELS_HAVE_NEON
+        case InstructionSet::neon:   return juce::SystemStats::hasNeon();
+       #endif
+        default: break;
+    }
+
+    return false;
+}
+
+InstructionSet getBestInstructionSet() noexcept
+{
+    static const auto best = []
+    {
+        for (auto candidate : { InstructionSet::avx512, InstructionSet::avx2,
+                                InstructionSet::sse2, InstructionSet::neon })
+            if (isSupported(candidate))
+                return candidate;
+
+        return InstructionSet::scalar;
+    }();
+
+    return best;
+}
+
+const char* getName(InstructionSet instructionSet) noexcept
+{
+    switch (instructionSet)
+    {
+        case InstructionSet::scalar: return "scalar";
+        case InstructionSet::sse2:   return "sse2";
+        case InstructionSet::avx2:   return "avx2";
+        case InstructionSet::avx512: return "avx512";
+        case InstructionSet::neon:   return "neon";
+    }
+
+    return "unknown";
+}
+
+template <>
+RampKernel<float> getRampKernel<float>(InstructionSet instructionSet) noexcept
+{
+    return selectRampKernel<float>(instructionSet);
+}
+
+template <>
+RampKernel<double> getRampKernel<double>(InstructionSet instructionSet) noexcept
+{
+    return selectRampKernel<double>(instructionSet);
+}
+
+template <>
+MeasureKernel<float> getMeasureKernel<float>(InstructionSet instructionSet) noexcept
+{
+    return selectMeasureKernel<float>(instructionSet);
+}
+
+template <>
+MeasureKernel<double> getMeasureKernel<double>(InstructionSet instructionSet) noexcept
+{
+    return selectMeasureKernel<double>(instructionSet);
+}
+}
@@ -0,0 +1,50 @@
+#include "../include/ParameterTable.h"
+
+namespace ParameterTable
+{
+//==============================================================================
+juce::NormalisableRange<float> makeRange(const Descriptor& descriptor)
+{
+    return { descriptor.minimum, descriptor.maximum, descriptor.step, descriptor.skew };
+}
+
+juce::AudioProcessorValueTreeState::ParameterLayout createLayout()
+{
+    juce::AudioProcessorValueTreeState::ParameterLayout layout;
+
+    for (const auto& descriptor : descriptors)
+    {
+        if (descriptor.kind == Kind::choice)
+        {
+            layout.add(std::make_unique<juce::AudioParameterChoice>(
+                descriptor.id, descriptor.name,
+                juce::StringArray(descriptor.choices, descriptor.numChoices),
+                juce::roundToInt(descriptor.defaultValue),
+                juce::AudioParameterChoiceAttributes().withAutomatable(descriptor.automatable)));
+        }
+        else
+        {
+            layout.add(std::make_unique<juce::AudioParameterFloat>(
+                descriptor.id, descriptor.name, makeRange(descriptor), descriptor.defaultValue,
+                juce::AudioParameterFloatAttributes().withAutomatable(descriptor.automatable)));
+        }
+    }
+
+    return layout;
+}
+
+//==============================================================================
+void Handles::resolve(juce::AudioProcessorValueTreeState& apvts)
+{
+    for (const auto& descriptor : descriptors)
+    {
+        const auto index = static_cast<size_t>(descriptor.identifier);
+        parameters[index] = apvts.getParameter(descriptor.id);
+        values[index] = apvts.getRawParameterValue(descriptor.id);
+
+        // The layout is built from the table, so indices follow the rows
+        jassert(parameters[index] != nullptr && values[index] != nullptr);
+        jassert(parameters[index]->getParameterIndex() == indexOf(descriptor.identifier));
+    }
+}
+}
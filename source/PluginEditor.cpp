@@ -1,45 +1,158 @@
 #include "../include/PluginProcessor.h"
 #include "../include/PluginEditor.h"
 
+namespace
+{
+    constexpr float meterFloorDb = -60.0f;
+    constexpr float meterCeilingDb = 6.0f;
+    constexpr float meterPeakFalloffDbPerSecond = 24.0f;
+    constexpr int profilerUpdatesPerSecond = 2;
+
+    /** Maps a linear level onto 0..1 of the meter's height. */
+    float meterProportion(float level) noexcept
+    {
+        const auto db = juce::Decibels::gainToDecibels(level, meterFloorDb);
+        return juce::jmap(juce::jlimit(meterFloorDb, meterCeilingDb, db), meterFloorDb, meterCeilingDb, 0.0f, 1.0f);
+    }
+}
+
 //==============================================================================
 AudioPluginEditor::AudioPluginEditor(AudioPluginProcessor& p)
     : AudioProcessorEditor(&p), audioProcessor(p)
 {
-    // Set editor size
+    // Controls and attachments come from the parameter table
+    for (int index = 0; index < ParameterTable::numParameters; ++index)
+    {
+        const auto& descriptor = ParameterTable::descriptors[static_cast<size_t>(index)];
+
+        if (descriptor.editorControl != ParameterTable::EditorControl::rotary)
+            continue;
+
+        auto control = std::make_unique<ParameterControl>();
+        control->parameterIndex = index;
+
+        control->slider.setSliderStyle(juce::Slider::RotaryVerticalDrag);
+        control->slider.setTextBoxStyle(juce::Slider::TextBoxBelow, false, 80, 20);
+        control->slider.setPopupDisplayEnabled(true, true, this);
+        control->slider.setTextValueSuffix(descriptor.unitSuffix);
+        addAndMakeVisible(control->slider);
+
+#if PLUGIN_MIDI_CONTROL
+        // Right-click for MIDI learn
+        control->slider.addMouseListener(this, false);
+#endif
+
+        control->label.setText(descriptor.name, juce::dontSendNotification);
+        control->label.setJustificationType(juce::Justification::centred);
+        control->label.attachToComponent(&control->slider, false);
+        addAndMakeVisible(control->label);
+
+        control->attachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
+            audioProcessor.getValueTreeState(), descriptor.id, control->slider);
+
+        parameterControls.push_back(std::move(control));
+    }
+
+    // Set editor size (lays out the controls above)
     setSize(400, 300);
 
-    // Setup gain slider
-    gainSlider.setSliderStyle(juce::Slider::RotaryVerticalDrag);
-    gainSlider.setTextBoxStyle(juce::Slider::TextBoxBelow, false, 80, 20);
-    gainSlider.setPopupDisplayEnabled(true, true, this);
-    gainSlider.setTextValueSuffix(" dB");
-    addAndMakeVisible(gainSlider);
-
-    // Setup gain label
-    gainLabel.setText("Gain", juce::dontSendNotification);
-    gainLabel.setJustificationType(juce::Justification::centred);
-    gainLabel.attachToComponent(&gainSlider, false);
-    addAndMakeVisible(gainLabel);
-
-    // Attach slider to parameter
-    gainAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
-        audioProcessor.getValueTreeState(),
-        "gain",
-        gainSlider
-    );
+    // CPU panel, collapsed by default
+    profilerToggle.setClickingTogglesState(true);
+    profilerToggle.onClick = [this]
+    {
+        // Start each viewing with a fresh maximum and window
+        audioProcessor.getBlockProfiler().resetMax();
+        lastProfilerSnapshot = audioProcessor.getBlockProfiler().getSnapshot();
+        framesUntilProfilerUpdate = 0;
+        profilerLabel.setText("measuring...", juce::dontSendNotification);
+        profilerLabel.setVisible(profilerToggle.getToggleState());
+        resized();
+    };
+    addAndMakeVisible(profilerToggle);
+
+    profilerLabel.setJustificationType(juce::Justification::centred);
+    profilerLabel.setFont(juce::Font(12.0f));
+    addChildComponent(profilerLabel);
+
+    impulseButton.onClick = [this] { showImpulseResponseMenu(); };
+    addAndMakeVisible(impulseButton);
+
+    // The cached background covers every pixel, so nothing behind us needs painting
+    setOpaque(true);
+
+#if PLUGIN_USE_OPENGL
+    // Let the GPU composite the editor where OpenGL is available
+    openGLContext.attachTo(*this);
+#endif
 
     // Make the UI resizable (optional)
     setResizable(true, true);
     setResizeLimits(300, 200, 800, 600);
+
+    setFrameRate(defaultFrameRateHz);
 }
 
 AudioPluginEditor::~AudioPluginEditor()
 {
+    stopTimer();
+    audioProcessor.getLevelMeters().setEnabled(false);
+
+#if PLUGIN_USE_OPENGL
+    openGLContext.detach();
+#endif
 }
 
 //==============================================================================
 void AudioPluginEditor::paint(juce::Graphics& g)
 {
+    // Being painted means being shown, even if no visibility callback said so
+    // (e.g. a host window restored from minimised)
+    if (! isTimerRunning())
+        updateTimer();
+
+    if (backgroundCache.isNull())
+        renderBackground();
+
+    g.drawImage(backgroundCache, getLocalBounds().toFloat());
+    paintMeters(g);
+}
+
+void AudioPluginEditor::paintMeters(juce::Graphics& g) const
+{
+    if (numMeterChannels == 0 || meterBounds.isEmpty())
+        return;
+
+    const auto area = meterBounds.toFloat();
+    const auto channelWidth = area.getWidth() / static_cast<float>(numMeterChannels);
+
+    for (int ch = 0; ch < numMeterChannels; ++ch)
+    {
+        const auto column = area.withX(area.getX() + channelWidth * static_cast<float>(ch))
+                                .withWidth(channelWidth)
+                                .reduced(channelWidth > 4.0f ? 1.0f : 0.0f, 0.0f);
+
+        const auto rmsHeight = column.getHeight() * meterProportion(meterRms[static_cast<size_t>(ch)]);
+        g.setColour(juce::Colours::limegreen);
+        g.fillRect(column.withTop(column.getBottom() - rmsHeight));
+
+        const auto peakY = column.getBottom() - column.getHeight() * meterProportion(meterPeaks[static_cast<size_t>(ch)]);
+        g.setColour(meterPeaks[static_cast<size_t>(ch)] >= 1.0f ? juce::Colours::red : juce::Colours::white);
+        g.fillRect(column.withY(peakY).withHeight(1.0f));
+    }
+}
+
+void AudioPluginEditor::renderBackground()
+{
+    // Render at the display's pixel density so the cache stays sharp on HiDPI screens
+    const auto scale = juce::Component::getApproximateScaleFactorForComponent(this);
+    const auto width = juce::jmax(1, juce::roundToInt(static_cast<float>(getWidth()) * scale));
+    const auto height = juce::jmax(1, juce::roundToInt(static_cast<float>(getHeight()) * scale));
+
+    backgroundCache = juce::Image(juce::Image::RGB, width, height, false);
+    juce::Graphics g(backgroundCache);
+    g.addTransform(juce::AffineTransform::scale(static_cast<float>(width) / static_cast<float>(juce::jmax(1, getWidth())),
+                                                static_cast<float>(height) / static_cast<float>(juce::jmax(1, getHeight()))));
+
     // Background
     g.fillAll(getLookAndFeel().findColour(juce::ResizableWindow::backgroundColourId));
 
@@ -51,6 +164,10 @@ void AudioPluginEditor::paint(juce::Graphics& g)
                      juce::Justification::centred,
                      1);
 
+    // Meter track; the levels are drawn over it in paint()
+    g.setColour(juce::Colours::black.withAlpha(0.4f));
+    g.fillRect(meterBounds);
+
     // Plugin info
     g.setFont(12.0f);
     g.setColour(juce::Colours::lightgrey);
@@ -63,6 +180,10 @@ void AudioPluginEditor::paint(juce::Graphics& g)
 
 void AudioPluginEditor::resized()
 {
+    // Re-rendered on the next paint, so editors that are created but never
+    // shown (or resized several times before showing) don't render at all
+    backgroundCache = {};
+
     auto bounds = getLocalBounds();
 
     // Leave space for title
@@ -71,7 +192,191 @@ void AudioPluginEditor::resized()
     // Leave space for footer
     bounds.removeFromBottom(30);
 
-    // Center the gain slider
-    auto sliderBounds = bounds.withSizeKeepingCentre(150, 150);
-    gainSlider.setBounds(sliderBounds);
+    profilerToggle.setBounds(getLocalBounds().removeFromTop(28).removeFromLeft(56).reduced(4));
+    impulseButton.setBounds(getLocalBounds().removeFromTop(28).removeFromRight(56).reduced(4));
+
+    if (profilerLabel.isVisible())
+        profilerLabel.setBounds(bounds.removeFromBottom(24));
+
+    // Output meters down the right-hand side
+    meterBounds = bounds.removeFromRight(40).reduced(8, 0);
+
+    // Controls side by side, centred, shrinking to fit
+    if (! parameterControls.empty())
+    {
+        const auto numControls = static_cast<int>(parameterControls.size());
+        const auto size = juce::jmin(150, bounds.getHeight(), bounds.getWidth() / numControls);
+        auto row = bounds.withSizeKeepingCentre(size * numControls, size);
+
+        for (auto& control : parameterControls)
+            control->slider.setBounds(row.removeFromLeft(size));
+    }
+}
+
+//==============================================================================
+void AudioPluginEditor::mouseDown(const juce::MouseEvent& event)
+{
+    if (! event.mods.isPopupMenu())
+        return;
+
+    for (const auto& control : parameterControls)
+        if (event.eventComponent == &control->slider)
+            showMidiLearnMenu(*control);
+}
+
+void AudioPluginEditor::showMidiLearnMenu(const ParameterControl& control)
+{
+    auto& processor = audioProcessor;
+    auto& map = processor.getMidiControlMap();
+    const auto parameterIndex = control.parameterIndex;
+    const auto isLearning = map.getLearningParameter() == parameterIndex;
+
+    juce::PopupMenu menu;
+    menu.addItem("MIDI Learn", true, isLearning, [&processor, &map, parameterIndex, isLearning]
+    {
+        if (isLearning)
+            map.stopLearning();
+        else
+            map.startLearning(parameterIndex); // the next CC processBlock sees is assigned
+
+        processor.updateMidiSync();
+    });
+    menu.addItem("Forget MIDI", [&processor, &map, parameterIndex]
+    {
+        map.clearMappingsFor(parameterIndex);
+        processor.updateMidiSync();
+    });
+    menu.showMenuAsync(juce::PopupMenu::Options().withTargetComponent(control.slider));
+}
+
+//==============================================================================
+void AudioPluginEditor::showImpulseResponseMenu()
+{
+    if (! audioProcessor.hasImpulseResponse())
+    {
+        chooseImpulseResponse();
+        return;
+    }
+
+    juce::PopupMenu menu;
+    menu.addItem("Load IR...", [this] { chooseImpulseResponse(); });
+    menu.addItem("Clear IR", [this] { audioProcessor.clearImpulseResponse(); });
+    menu.showMenuAsync(juce::PopupMenu::Options().withTargetComponent(impulseButton));
+}
+
+void AudioPluginEditor::chooseImpulseResponse()
+{
+    impulseChooser = std::make_unique<juce::FileChooser>("Load Impulse Response", juce::File(), "*.wav;*.aif;*.aiff;*.flac");
+
+    impulseChooser->launchAsync(juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectFiles,
+                                [this](const juce::FileChooser& chooser)
+    {
+        const auto file = chooser.getResult();
+
+        if (! file.existsAsFile())
+            return;
+
+        // The editor may be closed before the IR has been decoded
+        juce::Component::SafePointer<AudioPluginEditor> safeThis(this);
+
+        audioProcessor.loadImpulseResponse(file, [safeThis, file](bool loaded)
+        {
+            if (! loaded && safeThis != nullptr)
+                juce::AlertWindow::showMessageBoxAsync(juce::MessageBoxIconType::WarningIcon, "Load Impulse Response",
+                                                       "Couldn't read " + file.getFileName());
+        });
+    });
+}
+
+//==============================================================================
+void AudioPluginEditor::setFrameRate(int framesPerSecond)
+{
+    frameRateHz = juce::jlimit(1, 120, framesPerSecond);
+
+    // Keep the peak falloff in dB per second independent of the frame rate
+    peakDecayPerFrame = juce::Decibels::decibelsToGain(-meterPeakFalloffDbPerSecond / static_cast<float>(frameRateHz));
+    updateTimer();
+}
+
+void AudioPluginEditor::visibilityChanged()
+{
+    updateTimer();
+}
+
+void AudioPluginEditor::parentHierarchyChanged()
+{
+    // Hosts often make the editor visible before adding it to their window,
+    // so it only starts showing here
+    updateTimer();
+}
+
+void AudioPluginEditor::updateTimer()
+{
+    // Hidden editors don't need a frame clock, and the processor can skip metering
+    const auto showing = isShowing();
+    audioProcessor.getLevelMeters().setEnabled(showing);
+
+    if (showing)
+        startTimerHz(frameRateHz);
+    else
+        stopTimer();
+}
+
+void AudioPluginEditor::timerCallback()
+{
+    updateMeters();
+
+    if (profilerLabel.isVisible() && --framesUntilProfilerUpdate <= 0)
+    {
+        framesUntilProfilerUpdate = juce::jmax(1, frameRateHz / profilerUpdatesPerSecond);
+        updateProfilerText();
+    }
+
+    if (pendingRepaintArea.isEmpty())
+        return;
+
+    repaint(pendingRepaintArea);
+    pendingRepaintArea = {};
+}
+
+void AudioPluginEditor::updateMeters()
+{
+    auto& meters = audioProcessor.getLevelMeters();
+    const auto numChannels = meters.getNumChannels();
+    auto changed = numChannels != numMeterChannels;
+    numMeterChannels = numChannels;
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        const auto index = static_cast<size_t>(ch);
+        const auto peak = juce::jmax(meters.readPeak(ch), meterPeaks[index] * peakDecayPerFrame);
+        const auto rms = meters.getRms(ch);
+
+        // Only repaint when something would move by at least a pixel-ish amount
+        changed = changed || std::abs(meterProportion(peak) - meterProportion(meterPeaks[index])) > 0.002f
+                          || std::abs(meterProportion(rms) - meterProportion(meterRms[index])) > 0.002f;
+
+        meterPeaks[index] = peak;
+        meterRms[index] = rms;
+    }
+
+    if (changed)
+        requestRepaint(meterBounds);
+}
+
+void AudioPluginEditor::updateProfilerText()
+{
+    const auto snapshot = audioProcessor.getBlockProfiler().getSnapshot();
+    const auto stats = BlockProfiler::computeStats(snapshot, lastProfilerSnapshot);
+
+    if (stats.numBlocks == 0)
+        return; // not processing; keep showing the last figures
+
+    lastProfilerSnapshot = snapshot;
+
+    profilerLabel.setText("avg " + juce::String(stats.averageMicros, 1) + " us   p99 "
+                              + juce::String(stats.p99Micros, 1) + " us   max "
+                              + juce::String(stats.maxMicros, 1) + " us   "
+                              + juce::String(stats.budgetPercent, 2) + "% of budget",
+                          juce::dontSendNotification);
 }
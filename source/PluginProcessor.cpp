@@ -1,5 +1,13 @@
 #include "../include/PluginProcessor.h"
 #include "../include/PluginEditor.h"
+#include "../include/StateFormat.h"
+#include "../include/RealtimeGuard.h"
+
+namespace
+{
+    /** Distinguishes instances in profiler log file names. */
+    std::atomic<int> instanceCounter { 0 };
+}
 
 //==============================================================================
 AudioPluginProcessor::AudioPluginProcessor()
@@ -11,43 +19,43 @@ AudioPluginProcessor::AudioPluginProcessor()
                          .withOutput("Output", juce::AudioChannelSet::stereo(), true)
 #endif
                          ),
-      apvts(*this, nullptr, "Parameters", createParameterLayout())
+      apvts(*this, nullptr, "Parameters", createParameterLayout()),
+      instanceNumber(++instanceCounter)
 {
-    // Get parameter pointers for efficient access
-    gainParameter = apvts.getRawParameterValue("gain");
+    // Resolve every parameter once, in table order. This runs for every
+    // instance a host scans, so everything else (kernels, oversamplers,
+    // scratch memory) waits for prepareToPlay.
+    parameterHandles.resolve(apvts);
+    gainRange = ParameterTable::makeRange(ParameterTable::get(ParameterTable::Id::gain));
+    ceilingRange = ParameterTable::makeRange(ParameterTable::get(ParameterTable::Id::limiterCeiling));
+
+    jassert(getParameters().size() <= StateSnapshot::maxValues);
+
+    for (auto& value : midiPendingValues)
+        value.store(std::numeric_limits<float>::quiet_NaN(), std::memory_order_relaxed);
+
+    for (auto* parameter : getParameters())
+        parameter->addListener(this);
+
+    // Loads finish asynchronously, on the message thread
+    convolution.onImpulseChanged = [this] { impulseResponseChanged(); };
 }
 
 AudioPluginProcessor::~AudioPluginProcessor()
 {
+    stopTimer();
+    cancelPendingUpdate();
+    stopProfilerLog();
+
+    for (auto* parameter : getParameters())
+        parameter->removeListener(this);
 }
 
 //==============================================================================
 juce::AudioProcessorValueTreeState::ParameterLayout AudioPluginProcessor::createParameterLayout()
 {
-    juce::AudioProcessorValueTreeState::ParameterLayout layout;
-
-    // Example: Gain parameter (-60 dB to +12 dB)
-    layout.add(std::make_unique<juce::AudioParameterFloat>(
-        "gain",                          // Parameter ID
-        "Gain",                          // Parameter name
-        juce::NormalisableRange<float>(
-            -60.0f,                      // Min value (dB)
-            12.0f,                       // Max value (dB)
-            0.1f,                        // Step size
-            1.0f                         // Skew factor (1.0 = linear)
-        ),
-        0.0f                             // Default value (dB)
-    ));
-
-    // Add more parameters here as needed
-    // Example:
-    // layout.add(std::make_unique<juce::AudioParameterFloat>(
-    //     "frequency", "Frequency",
-    //     juce::NormalisableRange<float>(20.0f, 20000.0f, 1.0f, 0.25f),
-    //     1000.0f
-    // ));
-
-    return layout;
+    // Parameters are declared in ParameterTable.h; add new ones there
+    return ParameterTable::createLayout();
 }
 
 //==============================================================================
@@ -85,31 +93,80 @@ bool AudioPluginProcessor::isMidiEffect() const
 
 double AudioPluginProcessor::getTailLengthSeconds() const
 {
-    return 0.0;
+    return tailLengthSeconds.load(std::memory_order_relaxed);
 }
 
 //==============================================================================
 int AudioPluginProcessor::getNumPrograms()
 {
-    return 1; // Some hosts require at least 1 program
+    // Some hosts require at least 1 program
+    return presetBank != nullptr ? presetBank->getNumPrograms() : 1;
 }
 
 int AudioPluginProcessor::getCurrentProgram()
 {
-    return 0;
+    return currentProgram.load(std::memory_order_relaxed);
 }
 
-void AudioPluginProcessor::setCurrentProgram(int /*index*/)
+void AudioPluginProcessor::setCurrentProgram(int index)
 {
+    if (presetBank == nullptr || ! presetBank->isValidProgram(index))
+        return;
+
+    currentProgram.store(index, std::memory_order_relaxed);
+
+    // The row was decoded when the bank was opened: no parsing, no ValueTree,
+    // no allocation here. Changes reach processBlock through the parameter
+    // event queue and are ramped like automation; latency settings are
+    // applied on the message thread as usual.
+    const auto* values = presetBank->getNormalisedValues(index);
+    const auto& parameters = getParameters();
+    const auto numParameters = juce::jmin(parameters.size(), presetBank->getNumParameters());
+
+    for (int i = 0; i < numParameters; ++i)
+    {
+        auto* parameter = parameters.getUnchecked(i);
+
+        if (! std::isnan(values[i]) && parameter->getValue() != values[i])
+            parameter->setValueNotifyingHost(values[i]);
+    }
 }
 
-const juce::String AudioPluginProcessor::getProgramName(int /*index*/)
+const juce::String AudioPluginProcessor::getProgramName(int index)
 {
-    return {};
+    return presetBank != nullptr ? presetBank->getProgramName(index) : juce::String();
 }
 
 void AudioPluginProcessor::changeProgramName(int /*index*/, const juce::String& /*newName*/)
 {
+    // Banks are read-only; rename by writing a new bank
+}
+
+bool AudioPluginProcessor::loadPresetBank(const juce::File& bankFile)
+{
+    auto bank = PresetBank::open(bankFile, *this);
+
+    if (bank == nullptr)
+        return false;
+
+    {
+        const juce::ScopedLock lock(getCallbackLock());
+        std::swap(presetBank, bank);
+        currentProgram.store(0, std::memory_order_relaxed);
+    }
+
+    // The old mapping is released here, outside the lock
+    bank.reset();
+    updateMidiSync();
+    updateHostDisplay(ChangeDetails().withProgramChanged(true));
+    return true;
+}
+
+PresetBank::Program AudioPluginProcessor::captureProgram(const juce::String& name)
+{
+    PresetBank::Program program { name, {} };
+    StateFormat::write(*this, program.state);
+    return program;
 }
 
 //==============================================================================
@@ -118,16 +175,281 @@ void AudioPluginProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
     // Initialize DSP processors
     juce::dsp::ProcessSpec spec;
     spec.sampleRate = sampleRate;
-    spec.maximumBlockSize = static_cast<juce::uint32>(samplesPerBlock);
+    // Hosts with variable buffers often under-report; prepare for at least a
+    // typical block so most overruns fit, and split anything larger
+    spec.maximumBlockSize = static_cast<juce::uint32>(juce::jmax(samplesPerBlock, minimumPreparedBlockSize));
     spec.numChannels = static_cast<juce::uint32>(getTotalNumOutputChannels());
 
-    gain.prepare(spec);
-    gain.setRampDurationSeconds(0.05); // 50ms ramp for smooth parameter changes
+    // The bottom of the gain range is treated as silence
+    const auto minimumGainDb = gainRange.start;
+
+    // Pick the realtime or offline profile; everything below is sized from it
+    activeProfile = makeProcessingProfile();
+
+    // Prepare both chains so the host may switch precision between sessions
+    floatChain.gain.setRampDurationSeconds(activeProfile.rampDurationSeconds);
+    floatChain.gain.setMinusInfinityDecibels(minimumGainDb);
+    floatChain.gain.prepare(spec);
+
+    doubleChain.gain.setRampDurationSeconds(activeProfile.rampDurationSeconds);
+    doubleChain.gain.setMinusInfinityDecibels(static_cast<double>(minimumGainDb));
+    doubleChain.gain.prepare(spec);
+
+    floatChain.measure = GainKernels::getMeasureKernel<float>(GainKernels::getBestInstructionSet());
+    doubleChain.measure = GainKernels::getMeasureKernel<double>(GainKernels::getBestInstructionSet());
+
+    // Start at the current value rather than ramping up from unity
+    const auto gainDb = parameterHandles.load(ParameterTable::Id::gain);
+    floatChain.gain.setTargetDecibels(gainDb, 0);
+    doubleChain.gain.setTargetDecibels(static_cast<double>(gainDb), 0);
+    parameterRefreshPending.store(true, std::memory_order_release);
+
+    // Shortest ramp used in sample-accurate mode, so 1-sample blocks can't click
+    minimumRampSamples = juce::jmax(1, juce::roundToInt(sampleRate * 0.001));
+
+    prepareArena(spec);
+
+    preparedSpec = spec;
+    prepareOversampling();
+    prepareConvolution(true);
+    prepareLimiter();
+    setLatencySamples(updateLatencyAndTail());
+    silentInputSamples = 0;
+
+    midiSyncAllowed = true;
+    updateMidiSync();
+
+    blockProfiler.prepare(sampleRate);
+    workerDeadlineTicksPerSample = workerDeadlineFraction * static_cast<double>(juce::Time::getHighResolutionTicksPerSecond())
+                                 / sampleRate;
+
+    if (profilerLog == nullptr)
+    {
+        const auto logDirectory = juce::SystemStats::getEnvironmentVariable("PLUGIN_PROFILE_LOG_DIR", {});
+
+        if (logDirectory.isNotEmpty())
+            startProfilerLog(juce::File(logDirectory).getChildFile(getName() + "-" + juce::String(instanceNumber) + ".csv"));
+    }
+}
+
+void AudioPluginProcessor::prepareArena(const juce::dsp::ProcessSpec& spec)
+{
+    // Float hosts rendering offline are processed through the double chain
+    const auto needsDoubleInternals = activeProfile.doublePrecisionInternals && ! isUsingDoublePrecision();
+    const auto numInternalChannels = static_cast<size_t>(juce::jmax(getTotalNumInputChannels(), getTotalNumOutputChannels()));
+    const auto maxBlockSize = static_cast<size_t>(spec.maximumBlockSize);
+
+    // The double chain runs the float-only convolution through a float copy
+    const auto runsDoubleChain = activeProfile.doublePrecisionInternals || isUsingDoublePrecision();
+    const auto needsConvolutionBuffer = runsDoubleChain;
+
+    // Look-ahead memory for the longest setting, so changing it never allocates
+    const auto numOutputChannels = static_cast<size_t>(getTotalNumOutputChannels());
+    const auto maxLookaheadSamples = static_cast<int>(std::ceil(spec.sampleRate * maxLimiterLookaheadMs * 0.001));
+
+    // Add every scratch buffer's size here, then carve them out below in the same order
+    size_t totalBytes = 0;
+
+    if (needsDoubleInternals)
+        totalBytes += DspArena::bytesForChannels<double>(numInternalChannels, maxBlockSize);
+
+    if (needsConvolutionBuffer)
+        totalBytes += DspArena::bytesForChannels<float>(numInternalChannels, maxBlockSize);
+
+    totalBytes += runsDoubleChain ? LookaheadLimiter<double>::bytesRequired(numOutputChannels, maxLookaheadSamples)
+                                  : LookaheadLimiter<float>::bytesRequired(numOutputChannels, maxLookaheadSamples);
+
+    arena.reset(totalBytes);
+
+    if (needsDoubleInternals)
+        doubleInternalsBuffer.setDataToReferTo(arena.allocateChannels<double>(numInternalChannels, maxBlockSize),
+                                               static_cast<int>(numInternalChannels),
+                                               static_cast<int>(maxBlockSize));
+    else
+        doubleInternalsBuffer.setSize(0, 0);
+
+    if (needsConvolutionBuffer)
+        convolutionBuffer.setDataToReferTo(arena.allocateChannels<float>(numInternalChannels, maxBlockSize),
+                                           static_cast<int>(numInternalChannels),
+                                           static_cast<int>(maxBlockSize));
+    else
+        convolutionBuffer.setSize(0, 0);
+
+    // Only the chain that will run gets limiter memory
+    if (runsDoubleChain)
+    {
+        doubleChain.limiter.prepare(spec.sampleRate, static_cast<int>(numOutputChannels), maxLookaheadSamples, arena);
+        floatChain.limiter.release();
+    }
+    else
+    {
+        floatChain.limiter.prepare(spec.sampleRate, static_cast<int>(numOutputChannels), maxLookaheadSamples, arena);
+        doubleChain.limiter.release();
+    }
+
+    jassert(arena.getBytesUsed() == totalBytes);
 }
 
 void AudioPluginProcessor::releaseResources()
 {
-    // Release any resources here
+    midiSyncAllowed = false;
+
+    // Hand over any last MIDI-driven values before the sync stops
+    if (isTimerRunning())
+    {
+        stopTimer();
+        timerCallback();
+    }
+}
+
+//==============================================================================
+AudioPluginProcessor::ProcessingProfile AudioPluginProcessor::makeProcessingProfile() const
+{
+    ProcessingProfile profile;
+    const auto gainSmoothingSeconds = ParameterTable::get(ParameterTable::Id::gain).smoothingSeconds;
+
+    if (isNonRealtime())
+    {
+        // Never below the live factor, so a bounce is at least as clean as playback
+        profile.oversamplingFactorIndex = juce::jmax(parameterHandles.loadIndex(ParameterTable::Id::offlineOversampling),
+                                                     parameterHandles.loadIndex(ParameterTable::Id::oversampling));
+        profile.rampDurationSeconds = gainSmoothingSeconds * 2.0;
+        profile.doublePrecisionInternals = true;
+    }
+    else
+    {
+        profile.oversamplingFactorIndex = parameterHandles.loadIndex(ParameterTable::Id::oversampling);
+        profile.rampDurationSeconds = gainSmoothingSeconds;
+    }
+
+    profile.oversamplingFactorIndex = juce::jlimit(0, 3, profile.oversamplingFactorIndex);
+    return profile;
+}
+
+//==============================================================================
+void AudioPluginProcessor::prepareOversampling()
+{
+    if (preparedSpec.sampleRate <= 0.0)
+        return;
+
+    // Offline renders can afford a higher factor than live playback
+    activeProfile.oversamplingFactorIndex = makeProcessingProfile().oversamplingFactorIndex;
+    const auto factorIndex = activeProfile.oversamplingFactorIndex;
+    const auto useFir = parameterHandles.loadIndex(ParameterTable::Id::oversamplingFilter) == 1;
+
+    // Only the chain that will actually run gets filters allocated
+    if (isUsingDoublePrecision() || activeProfile.doublePrecisionInternals)
+    {
+        prepareChainOversampling(doubleChain, factorIndex,
+                                 useFir ? juce::dsp::Oversampling<double>::filterHalfBandFIREquiripple
+                                        : juce::dsp::Oversampling<double>::filterHalfBandPolyphaseIIR);
+        floatChain.oversampling.reset();
+    }
+    else
+    {
+        prepareChainOversampling(floatChain, factorIndex,
+                                 useFir ? juce::dsp::Oversampling<float>::filterHalfBandFIREquiripple
+                                        : juce::dsp::Oversampling<float>::filterHalfBandPolyphaseIIR);
+        doubleChain.oversampling.reset();
+    }
+}
+
+void AudioPluginProcessor::prepareConvolution(bool forceRebuild)
+{
+    if (preparedSpec.sampleRate <= 0.0)
+        return;
+
+    const auto mode = parameterHandles.loadIndex(ParameterTable::Id::convolutionLatency) == 1
+                          ? ConvolutionStage::LatencyMode::lowestCpu
+                          : ConvolutionStage::LatencyMode::zeroLatency;
+
+    // Rebuilding re-partitions the IR, so only do it when something changed
+    if (forceRebuild || mode != convolution.getLatencyMode())
+        convolution.prepare(preparedSpec, mode);
+}
+
+void AudioPluginProcessor::prepareLimiter()
+{
+    if (preparedSpec.sampleRate <= 0.0)
+        return;
+
+    const auto choice = juce::jlimit(0, static_cast<int>(std::size(ParameterTable::limiterLookaheadMilliseconds)) - 1,
+                                     parameterHandles.loadIndex(ParameterTable::Id::limiterLookahead));
+    limiterLookaheadSamples = juce::roundToInt(preparedSpec.sampleRate * ParameterTable::limiterLookaheadMilliseconds[choice] * 0.001);
+
+    // The memory is already there; this only resets the delay and detector
+    floatChain.limiter.setLookaheadSamples(limiterLookaheadSamples);
+    doubleChain.limiter.setLookaheadSamples(limiterLookaheadSamples);
+}
+
+int AudioPluginProcessor::updateLatencyAndTail()
+{
+    if (preparedSpec.sampleRate <= 0.0)
+        return 0;
+
+    // Delays add up in any order: look-ahead, oversampling filters, convolution
+    int latency = limiterLookaheadSamples;
+
+    if (floatChain.oversampling != nullptr)
+        latency += juce::roundToInt(floatChain.oversampling->getLatencyInSamples());
+    else if (doubleChain.oversampling != nullptr)
+        latency += juce::roundToInt(doubleChain.oversampling->getLatencyInSamples());
+
+    // Gain is memoryless, so the ring-out is the delays plus the IR.
+    // Stages with state (filters, delays) must add their tail here.
+    int tail = latency;
+
+    if (convolution.isActive())
+    {
+        latency += convolution.getLatencySamples();
+        tail = latency + convolution.getTailSamples();
+    }
+
+    tailLengthSamples = tail;
+    tailLengthSeconds.store(static_cast<double>(tailLengthSamples) / preparedSpec.sampleRate,
+                            std::memory_order_relaxed);
+
+    return latency;
+}
+
+template <typename SampleType>
+void AudioPluginProcessor::prepareChainOversampling(DspChain<SampleType>& chain, int factorIndex,
+                                                    typename juce::dsp::Oversampling<SampleType>::FilterType filterType)
+{
+    if (factorIndex == 0)
+    {
+        chain.oversampling.reset();
+        return;
+    }
+
+    // Integer latency so the value reported to the host is exact
+    chain.oversampling = std::make_unique<juce::dsp::Oversampling<SampleType>>(
+        static_cast<size_t>(preparedSpec.numChannels),
+        static_cast<size_t>(factorIndex),
+        filterType,
+        true,  // max quality
+        true); // integer latency
+
+    chain.oversampling->initProcessing(static_cast<size_t>(preparedSpec.maximumBlockSize));
+    chain.oversampling->reset();
+}
+
+void AudioPluginProcessor::handleAsyncUpdate()
+{
+    // Message thread: swap the oversamplers and convolution engines while
+    // processBlock is locked out, then report the new latency once the lock
+    // is released
+    int latency = 0;
+
+    {
+        const juce::ScopedLock lock(getCallbackLock());
+        prepareOversampling();
+        prepareConvolution(false);
+        prepareLimiter();
+        latency = updateLatencyAndTail();
+    }
+
+    setLatencySamples(latency);
 }
 
 bool AudioPluginProcessor::isBusesLayoutSupported(const BusesLayout& layouts) const
@@ -136,9 +458,11 @@ bool AudioPluginProcessor::isBusesLayoutSupported(const BusesLayout& layouts) co
     juce::ignoreUnused(layouts);
     return true;
 #else
-    // Ensure stereo/mono I/O
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-        && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    // Any discrete or surround layout up to maxNumChannels; the gain is
+    // computed once per block and applied to every channel
+    const auto& mainOutput = layouts.getMainOutputChannelSet();
+
+    if (mainOutput.isDisabled() || mainOutput.size() > maxNumChannels)
         return false;
 
 #if !JucePlugin_IsSynth
@@ -151,26 +475,600 @@ bool AudioPluginProcessor::isBusesLayoutSupported(const BusesLayout& layouts) co
 #endif
 }
 
-void AudioPluginProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& /*midiMessages*/)
+template <typename SampleType>
+AudioPluginProcessor::DspChain<SampleType>& AudioPluginProcessor::getChain() noexcept
+{
+    if constexpr (std::is_same_v<SampleType, double>)
+        return doubleChain;
+    else
+        return floatChain;
+}
+
+template <typename SampleType>
+void AudioPluginProcessor::processBlockImpl(juce::AudioBuffer<SampleType>& buffer, juce::MidiBuffer& midiMessages,
+                                            int startSample, int numSamples, int midiStartSample)
 {
     juce::ScopedNoDenormals noDenormals;
+    publishStateSnapshot();
+
     auto totalNumInputChannels = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
 
     // Clear any output channels that don't have input
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
-        buffer.clear(i, 0, buffer.getNumSamples());
+        buffer.clear(i, startSample, numSamples);
+
+    auto& chain = getChain<SampleType>();
+    auto block = juce::dsp::AudioBlock<SampleType>(buffer).getSubBlock(static_cast<size_t>(startSample),
+                                                                       static_cast<size_t>(numSamples));
+
+    collectParameterEvents(numSamples);
+    collectMidiEvents(midiMessages, midiStartSample, numSamples);
+
+    // NaN, Inf and subnormal input is zeroed before any stage can keep it in
+    // its state; the same pass tells us whether the input is silent
+    const auto input = buffer.hasBeenCleared() ? InputSanitiser::Result { true, 0 }
+                                               : inputSanitiser.process(block, static_cast<size_t>(totalNumInputChannels));
+
+    // Short-circuit on silent input once any tail has rung out and the ramp has
+    // settled. Tiny blocks always take the normal path: the bookkeeping costs
+    // about as much as processing them.
+    if (numSamples > tinyBlockSize && totalNumInputChannels > 0 && input.isSilent)
+    {
+        silentInputSamples += numSamples;
+
+        if (silentInputSamples > tailLengthSamples && ! chain.gain.isSmoothing() && numBlockEvents == 0)
+        {
+            block.clear();
+            measureOutput(chain, block);
+            return;
+        }
+    }
+    else
+    {
+        silentInputSamples = 0;
+    }
+
+    // Process audio in segments split at parameter-change points
+    size_t eventIndex = 0;
+    int segmentStart = 0;
+
+    while (segmentStart < numSamples)
+    {
+        for (; eventIndex < numBlockEvents && blockEvents[eventIndex].sampleOffset <= segmentStart; ++eventIndex)
+        {
+            const auto& event = blockEvents[eventIndex];
+            const auto rampEnd = findNextEventOffset(eventIndex, event.parameterIndex, numSamples);
+            applyParameterEvent(chain, event, rampEnd - segmentStart);
+        }
+
+        const auto segmentEnd = eventIndex < numBlockEvents ? blockEvents[eventIndex].sampleOffset : numSamples;
+        const auto segment = block.getSubBlock(static_cast<size_t>(segmentStart),
+                                               static_cast<size_t>(segmentEnd - segmentStart));
+
+        chain.gain.process(segment);
+
+        segmentStart = segmentEnd;
+    }
+
+    // Zero-length blocks still carry parameter changes
+    for (; eventIndex < numBlockEvents; ++eventIndex)
+        applyParameterEvent(chain, blockEvents[eventIndex], 0);
 
-    // Update DSP parameters
-    float gainValue = juce::Decibels::decibelsToGain(gainParameter->load());
-    gain.setGainLinear(gainValue);
+    // Nonlinear stages run oversampled, ahead of the convolution and the limiter
+    if (chain.oversampling != nullptr && numSamples > 0)
+    {
+        auto oversampledBlock = chain.oversampling->processSamplesUp(block);
 
-    // Process audio
-    juce::dsp::AudioBlock<float> block(buffer);
-    juce::dsp::ProcessContextReplacing<float> context(block);
-    gain.process(context);
+        // Add nonlinear processing (saturation etc.) on oversampledBlock here.
+        // Until then the stage only band-limits, at the factor, filter and
+        // latency the parameters select.
+        juce::ignoreUnused(oversampledBlock);
+
+        chain.oversampling->processSamplesDown(block);
+    }
+
+    if (convolution.isActive() && numSamples > 0)
+        processConvolution(block);
 
     // Add your custom processing here
+
+    // Last, so nothing after it can push the output back over the ceiling
+    if (numSamples > 0)
+        chain.limiter.process(block);
+
+    // Tails decaying through the chain can end up subnormal where FTZ isn't in effect
+    if (numSamples > 0)
+        inputSanitiser.flushSubnormals(block);
+
+    measureOutput(chain, block);
+}
+
+template <typename SampleType>
+void AudioPluginProcessor::processConvolution(const juce::dsp::AudioBlock<SampleType>& block) noexcept
+{
+    if constexpr (std::is_same_v<SampleType, float>)
+    {
+        runConvolution(block);
+    }
+    else
+    {
+        // The engines are float only; convert through the arena copy
+        const auto numChannels = juce::jmin(static_cast<int>(block.getNumChannels()), convolutionBuffer.getNumChannels());
+        const auto numSamples = static_cast<int>(block.getNumSamples());
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            const auto* source = block.getChannelPointer(static_cast<size_t>(ch));
+            std::transform(source, source + numSamples, convolutionBuffer.getWritePointer(ch),
+                           [](double sample) { return static_cast<float>(sample); });
+        }
+
+        runConvolution(juce::dsp::AudioBlock<float>(convolutionBuffer).getSubBlock(0, static_cast<size_t>(numSamples))
+                                                                            .getSubsetChannelBlock(0, static_cast<size_t>(numChannels)));
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            const auto* result = convolutionBuffer.getReadPointer(ch);
+            std::copy(result, result + numSamples, block.getChannelPointer(static_cast<size_t>(ch)));
+        }
+    }
+}
+
+void AudioPluginProcessor::runConvolution(const juce::dsp::AudioBlock<float>& block) noexcept
+{
+    const auto numPairs = convolution.getNumPairs(block.getNumChannels());
+
+    if (workerPool == nullptr || numPairs < 2)
+    {
+        convolution.process(block);
+        return;
+    }
+
+    // Channel pairs have independent engines, so each is one task
+    struct Job
+    {
+        ConvolutionStage& stage;
+        const juce::dsp::AudioBlock<float>& block;
+    };
+
+    Job job { convolution, block };
+    const auto deadlineTicks = static_cast<juce::int64>(workerDeadlineTicksPerSample * static_cast<double>(block.getNumSamples()));
+
+    workerPool->run(numPairs, [](void* context, int pair) noexcept
+    {
+        auto& pairJob = *static_cast<Job*>(context);
+        pairJob.stage.processPair(pair, pairJob.block);
+    }, &job, deadlineTicks);
+}
+
+template <typename SampleType>
+void AudioPluginProcessor::measureOutput(const DspChain<SampleType>& chain, const juce::dsp::AudioBlock<SampleType>& block) noexcept
+{
+    if (! levelMeters.isEnabled())
+        return;
+
+    // Runs straight after the chain, while the block is still in cache
+    const auto numChannels = juce::jmin(getTotalNumOutputChannels(), static_cast<int>(block.getNumChannels()),
+                                        LevelMeters::maxChannels);
+    const auto numSamples = static_cast<int>(block.getNumSamples());
+    levelMeters.setNumChannels(numChannels);
+
+    if (numSamples == 0)
+        return;
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        SampleType peak {}, sumOfSquares {};
+        chain.measure(block.getChannelPointer(static_cast<size_t>(ch)), numSamples, peak, sumOfSquares);
+
+        levelMeters.publish(ch, static_cast<float>(peak),
+                            static_cast<float>(std::sqrt(sumOfSquares / static_cast<SampleType>(numSamples))));
+    }
+}
+
+template <typename SampleType>
+void AudioPluginProcessor::applyParameterEvent(DspChain<SampleType>& chain, const ParameterEvent& event, int rampSamples) noexcept
+{
+    // A non-finite value from a host would stick in the ramp or the limiter
+    if (! std::isfinite(event.value))
+        return;
+
+    if (event.parameterIndex == ParameterTable::indexOf(ParameterTable::Id::gain))
+    {
+        // The conversion to linear is skipped while the value is unchanged
+        const auto gainDb = static_cast<SampleType>(gainRange.convertFrom0to1(event.value));
+
+        if (automationMode.load(std::memory_order_relaxed) == AutomationMode::sampleAccurate)
+            // Interpolate towards the new value until the next change (or the end of the block)
+            chain.gain.setTargetDecibels(gainDb, juce::jmax(rampSamples, minimumRampSamples));
+        else
+            chain.gain.setTargetDecibels(gainDb);
+    }
+    else if (event.parameterIndex == ParameterTable::indexOf(ParameterTable::Id::limiterCeiling))
+    {
+        // Takes effect for the whole block; the limiter's attack ramp smooths it
+        chain.limiter.setCeilingDecibels(static_cast<SampleType>(ceilingRange.convertFrom0to1(event.value)));
+    }
+}
+
+void AudioPluginProcessor::collectParameterEvents(int numSamples) noexcept
+{
+    numBlockEvents = 0;
+
+    const auto lastOffset = juce::jmax(0, numSamples - 1);
+    const auto needsRefresh = parameterEvents.checkAndClearOverflow()
+                           || parameterRefreshPending.exchange(false, std::memory_order_acq_rel);
+
+    parameterEvents.drain([this, needsRefresh, lastOffset](ParameterEvent event)
+    {
+        if (needsRefresh)
+            return; // superseded by the full refresh below
+
+        event.sampleOffset = juce::jlimit(0, lastOffset, event.sampleOffset);
+        addBlockEvent(event);
+    });
+
+    if (needsRefresh)
+    {
+        const auto& parameters = getParameters();
+
+        for (int i = 0; i < parameters.size(); ++i)
+            addBlockEvent({ i, parameters.getUnchecked(i)->getValue(), 0 });
+    }
+}
+
+void AudioPluginProcessor::addBlockEvent(const ParameterEvent& event) noexcept
+{
+    // Coalesce repeated changes to the same parameter at the same position
+    for (size_t i = numBlockEvents; i > 0; --i)
+    {
+        auto& existing = blockEvents[i - 1];
+
+        if (existing.sampleOffset < event.sampleOffset)
+            break;
+
+        if (existing.sampleOffset == event.sampleOffset && existing.parameterIndex == event.parameterIndex)
+        {
+            existing.value = event.value;
+            return;
+        }
+    }
+
+    if (numBlockEvents == blockEvents.size())
+    {
+        parameterRefreshPending.store(true, std::memory_order_release);
+        return;
+    }
+
+    // Keep events sorted by offset; they almost always arrive in order
+    auto insertAt = numBlockEvents;
+
+    while (insertAt > 0 && blockEvents[insertAt - 1].sampleOffset > event.sampleOffset)
+    {
+        blockEvents[insertAt] = blockEvents[insertAt - 1];
+        --insertAt;
+    }
+
+    blockEvents[insertAt] = event;
+    ++numBlockEvents;
+}
+
+int AudioPluginProcessor::findNextEventOffset(size_t afterIndex, int parameterIndex, int numSamples) const noexcept
+{
+    for (auto i = afterIndex + 1; i < numBlockEvents; ++i)
+        if (blockEvents[i].parameterIndex == parameterIndex)
+            return blockEvents[i].sampleOffset;
+
+    return numSamples;
+}
+
+//==============================================================================
+void AudioPluginProcessor::collectMidiEvents(const juce::MidiBuffer& midiMessages, int midiStartSample, int numSamples) noexcept
+{
+    if (! midiControlMap.isActive() && presetBank == nullptr)
+        return;
+
+    const auto endSample = midiStartSample + numSamples;
+
+    for (auto it = midiMessages.findNextSamplePosition(midiStartSample); it != midiMessages.cend(); ++it)
+    {
+        const auto metadata = *it;
+
+        if (metadata.samplePosition >= endSample)
+            break;
+
+        // Read the status bytes directly: MidiMessage would copy (and allocate for) SysEx
+        if (metadata.numBytes < 2)
+            continue;
+
+        const auto status = metadata.data[0] & 0xf0;
+        const auto channel = (metadata.data[0] & 0x0f) + 1;
+        const auto offset = metadata.samplePosition - midiStartSample;
+
+#if PLUGIN_MIDI_CONTROL
+        if (status == 0xb0 && metadata.numBytes >= 3)
+        {
+            const auto controller = static_cast<int>(metadata.data[1]);
+            midiControlMap.learn(channel, controller);
+
+            const auto parameterIndex = midiControlMap.getParameterIndex(channel, controller);
+
+            if (parameterIndex != MidiControlMap::unmapped)
+                applyMidiValue(parameterIndex, static_cast<float>(metadata.data[2] & 0x7f) / 127.0f, offset);
+
+            continue;
+        }
+#endif
+
+        if (status == 0xc0)
+        {
+            applyMidiProgramChange(metadata.data[1] & 0x7f, offset);
+        }
+    }
+}
+
+void AudioPluginProcessor::applyMidiValue(int parameterIndex, float value, int sampleOffset) noexcept
+{
+    if (! ParameterTable::isValidIndex(parameterIndex))
+        return;
+
+    // The timer sets the parameter; the latest value wins
+    midiPendingValues[static_cast<size_t>(parameterIndex)].store(value, std::memory_order_relaxed);
+
+    // Latency settings wait for the parameter, like automation of them does
+    if (! ParameterTable::descriptors[static_cast<size_t>(parameterIndex)].changesLatency)
+        addBlockEvent({ parameterIndex, value, sampleOffset });
+}
+
+void AudioPluginProcessor::applyMidiProgramChange(int program, int sampleOffset) noexcept
+{
+    // Held under the callback lock, so the bank can't be swapped from under us
+    if (presetBank == nullptr || ! presetBank->isValidProgram(program))
+        return;
+
+    currentProgram.store(program, std::memory_order_relaxed);
+    midiProgramChanged.store(true, std::memory_order_relaxed);
+
+    const auto* values = presetBank->getNormalisedValues(program);
+    const auto numParameters = juce::jmin(ParameterTable::numParameters, presetBank->getNumParameters());
+
+    for (int i = 0; i < numParameters; ++i)
+        if (! std::isnan(values[i]))
+            applyMidiValue(i, values[i], sampleOffset);
+}
+
+void AudioPluginProcessor::timerCallback()
+{
+    const auto& parameters = getParameters();
+
+    for (int i = 0; i < ParameterTable::numParameters; ++i)
+    {
+        const auto value = midiPendingValues[static_cast<size_t>(i)].exchange(std::numeric_limits<float>::quiet_NaN(),
+                                                                              std::memory_order_relaxed);
+
+        if (std::isnan(value) || ! juce::isPositiveAndBelow(i, parameters.size()))
+            continue;
+
+        auto* parameter = parameters.getUnchecked(i);
+
+        if (parameter->getValue() == value)
+            continue;
+
+        // processBlock has already applied this value at its sample position,
+        // so parameterValueChanged mustn't queue it again
+        midiEchoIndex.store(i, std::memory_order_relaxed);
+        parameter->beginChangeGesture();
+        parameter->setValueNotifyingHost(value);
+        parameter->endChangeGesture();
+        midiEchoIndex.store(-1, std::memory_order_relaxed);
+    }
+
+    if (midiProgramChanged.exchange(false, std::memory_order_relaxed))
+        updateHostDisplay(ChangeDetails().withProgramChanged(true));
+
+    // Everything pending is handed over, so stop once nothing can add more
+    if (! needsMidiSync())
+        stopTimer();
+}
+
+bool AudioPluginProcessor::needsMidiSync() const noexcept
+{
+    if (! midiSyncAllowed || ! acceptsMidi())
+        return false;
+
+    // Only mapped (or learning) CCs and bank program changes move parameters
+#if PLUGIN_MIDI_CONTROL
+    if (midiControlMap.isActive())
+        return true;
+#endif
+
+    return presetBank != nullptr;
+}
+
+void AudioPluginProcessor::updateMidiSync()
+{
+    if (needsMidiSync())
+    {
+        if (! isTimerRunning())
+            startTimer(midiSyncIntervalMs);
+    }
+    else if (isTimerRunning())
+    {
+        stopTimer();
+        timerCallback();
+    }
+}
+
+bool AudioPluginProcessor::supportsDoublePrecisionProcessing() const
+{
+    return true;
+}
+
+void AudioPluginProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+{
+    const RealtimeGuard::ScopedRealtimeScope realtimeScope; // no-op unless PLUGIN_REALTIME_CHECKS
+    const BlockProfiler::ScopedTimer profilerTimer(blockProfiler, buffer.getNumSamples());
+    processInSubBlocks(buffer, midiMessages);
+}
+
+void AudioPluginProcessor::processBlock(juce::AudioBuffer<double>& buffer, juce::MidiBuffer& midiMessages)
+{
+    const RealtimeGuard::ScopedRealtimeScope realtimeScope;
+    const BlockProfiler::ScopedTimer profilerTimer(blockProfiler, buffer.getNumSamples());
+    processInSubBlocks(buffer, midiMessages);
+}
+
+template <typename SampleType>
+void AudioPluginProcessor::processInSubBlocks(juce::AudioBuffer<SampleType>& buffer, juce::MidiBuffer& midiMessages)
+{
+    // Blocks larger than the prepared size are split rather than reallocated:
+    // everything downstream was sized for preparedSpec.maximumBlockSize
+    const auto totalNumSamples = buffer.getNumSamples();
+    const auto maxSubBlockSize = juce::jmax(1, static_cast<int>(preparedSpec.maximumBlockSize));
+    int startSample = 0;
+
+    do
+    {
+        const auto numSamples = juce::jmin(maxSubBlockSize, totalNumSamples - startSample);
+
+        if constexpr (std::is_same_v<SampleType, float>)
+        {
+            if (activeProfile.doublePrecisionInternals)
+            {
+                processWithDoubleInternals(buffer, midiMessages, startSample, numSamples);
+                startSample += numSamples;
+                continue;
+            }
+        }
+
+        processBlockImpl(buffer, midiMessages, startSample, numSamples, startSample);
+        startSample += numSamples;
+    }
+    while (startSample < totalNumSamples);
+}
+
+void AudioPluginProcessor::processWithDoubleInternals(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages,
+                                                      int startSample, int numSamples)
+{
+    // The buffer lives in the arena at the prepared size and sub-blocks never
+    // exceed it, so only its first numSamples are used
+    const auto numChannels = juce::jmin(buffer.getNumChannels(), doubleInternalsBuffer.getNumChannels());
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        const auto* source = buffer.getReadPointer(ch, startSample);
+        std::copy(source, source + numSamples, doubleInternalsBuffer.getWritePointer(ch));
+    }
+
+    processBlockImpl(doubleInternalsBuffer, midiMessages, 0, numSamples, startSample);
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        const auto* result = doubleInternalsBuffer.getReadPointer(ch);
+        std::transform(result, result + numSamples, buffer.getWritePointer(ch, startSample),
+                       [](double sample) { return static_cast<float>(sample); });
+    }
+}
+
+void AudioPluginProcessor::startProfilerLog(const juce::File& csvFile, int intervalMilliseconds)
+{
+    profilerLog.reset();
+
+    if (csvFile.getParentDirectory().createDirectory().wasOk())
+        profilerLog = std::make_unique<BlockProfilerLog>(blockProfiler, csvFile, intervalMilliseconds);
+}
+
+void AudioPluginProcessor::stopProfilerLog()
+{
+    profilerLog.reset();
+}
+
+//==============================================================================
+void AudioPluginProcessor::loadImpulseResponse(const juce::File& file, std::function<void(bool loaded)> onLoaded)
+{
+    convolution.loadImpulseResponse(file, std::move(onLoaded));
+}
+
+void AudioPluginProcessor::loadImpulseResponse(juce::AudioBuffer<float>&& impulseResponse, double impulseSampleRate,
+                                               std::function<void(bool loaded)> onLoaded)
+{
+    convolution.loadImpulseResponse(std::move(impulseResponse), impulseSampleRate, std::move(onLoaded));
+}
+
+void AudioPluginProcessor::impulseResponseChanged()
+{
+    int latency = 0;
+
+    {
+        const juce::ScopedLock lock(getCallbackLock());
+        latency = updateLatencyAndTail();
+    }
+
+    setLatencySamples(latency);
+}
+
+void AudioPluginProcessor::clearImpulseResponse()
+{
+    int latency = 0;
+
+    {
+        // processBlock may be inside the engines, so bypass under the lock
+        const juce::ScopedLock lock(getCallbackLock());
+        convolution.clearImpulseResponse();
+        latency = updateLatencyAndTail();
+    }
+
+    setLatencySamples(latency);
+}
+
+//==============================================================================
+void AudioPluginProcessor::setNumWorkerThreads(int numThreads)
+{
+    numThreads = juce::jlimit(0, WorkerPool::maxWorkers, numThreads);
+
+    if (numThreads == getNumWorkerThreads())
+        return;
+
+    // Threads are started and stopped outside the callback lock; only the
+    // pointer swap blocks processBlock
+    std::unique_ptr<WorkerPool> pool;
+
+    if (numThreads > 0)
+    {
+        pool = std::make_unique<WorkerPool>(numThreads);
+
+        const juce::SpinLock::ScopedLockType lock(workgroupLock);
+        pool->setWorkgroup(audioWorkgroup);
+    }
+
+    {
+        const juce::ScopedLock lock(getCallbackLock());
+        std::swap(workerPool, pool);
+    }
+}
+
+void AudioPluginProcessor::audioWorkgroupContextChanged(const juce::AudioWorkgroup& workgroup)
+{
+    {
+        const juce::SpinLock::ScopedLockType lock(workgroupLock);
+        audioWorkgroup = workgroup;
+    }
+
+    const juce::ScopedLock lock(getCallbackLock());
+
+    if (workerPool != nullptr)
+        workerPool->setWorkgroup(workgroup);
+}
+
+void AudioPluginProcessor::setAutomationMode(AutomationMode newMode) noexcept
+{
+    automationMode.store(newMode, std::memory_order_relaxed);
+}
+
+AudioPluginProcessor::AutomationMode AudioPluginProcessor::getAutomationMode() const noexcept
+{
+    return automationMode.load(std::memory_order_relaxed);
 }
 
 //==============================================================================
@@ -190,20 +1088,81 @@ juce::AudioProcessorEditor* AudioPluginProcessor::createEditor()
 //==============================================================================
 void AudioPluginProcessor::getStateInformation(juce::MemoryBlock& destData)
 {
-    // Save parameters to XML
-    auto state = apvts.copyState();
-    std::unique_ptr<juce::XmlElement> xml(state.createXml());
-    copyXmlToBinary(*xml, destData);
+    // Save parameters and MIDI assignments in the flat binary format (see
+    // StateFormat.h), preferring the audio thread's snapshot so every value
+    // comes from the same block. Neither path takes a lock, so autosave can't
+    // stall processBlock.
+    std::array<float, StateSnapshot::maxValues> values;
+    const auto numParameters = getParameters().size();
+
+    if (stateSnapshot.read(values.data(), numParameters, parameterGeneration.load(std::memory_order_acquire)))
+        StateFormat::write(*this, values.data(), destData, &midiControlMap);
+    else
+        StateFormat::write(*this, destData, &midiControlMap);
 }
 
 void AudioPluginProcessor::setStateInformation(const void* data, int sizeInBytes)
 {
-    // Restore parameters from XML
+    if (StateFormat::read(*this, data, sizeInBytes, &midiControlMap))
+    {
+        updateMidiSync();
+        return;
+    }
+
+    // Fall back to the XML states written by earlier versions, which predate
+    // MIDI learn, so they restore without assignments
     std::unique_ptr<juce::XmlElement> xmlState(getXmlFromBinary(data, sizeInBytes));
 
-    if (xmlState != nullptr)
-        if (xmlState->hasTagName(apvts.state.getType()))
-            apvts.replaceState(juce::ValueTree::fromXml(*xmlState));
+    if (xmlState != nullptr && xmlState->hasTagName(apvts.state.getType()))
+    {
+        apvts.replaceState(juce::ValueTree::fromXml(*xmlState));
+        midiControlMap.clearAll();
+        updateMidiSync();
+    }
+}
+
+//==============================================================================
+void AudioPluginProcessor::parameterValueChanged(int parameterIndex, float newValue)
+{
+    parameterGeneration.fetch_add(1, std::memory_order_release);
+
+    // Latency changes (oversampling, convolution, look-ahead) are applied on the message thread
+    if (ParameterTable::isValidIndex(parameterIndex)
+        && ParameterTable::descriptors[static_cast<size_t>(parameterIndex)].changesLatency)
+    {
+        triggerAsyncUpdate();
+        return;
+    }
+
+    // Set by the MIDI sync after processBlock already applied it
+    if (parameterIndex == midiEchoIndex.load(std::memory_order_relaxed))
+        return;
+
+    // Applied at the start of the next block
+    parameterEvents.push({ parameterIndex, newValue, 0 });
+}
+
+void AudioPluginProcessor::parameterGestureChanged(int /*parameterIndex*/, bool /*gestureIsStarting*/)
+{
+}
+
+void AudioPluginProcessor::publishStateSnapshot() noexcept
+{
+    // Read the generation before the values: a change that lands mid-publish
+    // bumps it past this one, and readers fall back to the live parameters
+    const auto generation = parameterGeneration.load(std::memory_order_acquire);
+
+    // Nothing changed since the last publish, so that snapshot is still current
+    if (generation == lastPublishedGeneration)
+        return;
+
+    lastPublishedGeneration = generation;
+    const auto& parameters = getParameters();
+
+    stateSnapshot.publish(generation, parameters.size(), [&parameters](int index)
+    {
+        return parameters.getUnchecked(index)->getValue();
+    });
 }
 
 //==============================================================================
@@ -0,0 +1,113 @@
+#include "../include/PresetBank.h"
+#include "../include/StateFormat.h"
+
+namespace
+{
+    constexpr size_t headerSize = 8;
+    constexpr size_t entrySize = 16;
+
+    bool isInside(size_t offset, size_t length, size_t fileSize) noexcept
+    {
+        return offset <= fileSize && length <= fileSize - offset;
+    }
+}
+
+//==============================================================================
+std::unique_ptr<PresetBank> PresetBank::open(const juce::File& file, const juce::AudioProcessor& processor)
+{
+    auto mapping = std::make_unique<juce::MemoryMappedFile>(file, juce::MemoryMappedFile::readOnly);
+    const auto* bytes = static_cast<const char*>(mapping->getData());
+    const auto fileSize = mapping->getSize();
+
+    if (bytes == nullptr || fileSize < headerSize
+        || juce::ByteOrder::littleEndianInt(bytes) != magic
+        || juce::ByteOrder::littleEndianShort(bytes + 4) != currentVersion)
+        return nullptr;
+
+    const auto numPrograms = static_cast<int>(juce::ByteOrder::littleEndianShort(bytes + 6));
+
+    if (numPrograms <= 0 || numPrograms > maxPrograms
+        || ! isInside(headerSize, static_cast<size_t>(numPrograms) * entrySize, fileSize))
+        return nullptr;
+
+    std::unique_ptr<PresetBank> bank(new PresetBank());
+    bank->numParameters = processor.getParameters().size();
+    bank->names.reserve(static_cast<size_t>(numPrograms));
+    bank->values.assign(static_cast<size_t>(numPrograms) * static_cast<size_t>(bank->numParameters),
+                        std::numeric_limits<float>::quiet_NaN());
+
+    for (int program = 0; program < numPrograms; ++program)
+    {
+        const auto* entry = bytes + headerSize + static_cast<size_t>(program) * entrySize;
+        const auto nameOffset = static_cast<size_t>(juce::ByteOrder::littleEndianInt(entry));
+        const auto nameLength = static_cast<size_t>(juce::ByteOrder::littleEndianInt(entry + 4));
+        const auto stateOffset = static_cast<size_t>(juce::ByteOrder::littleEndianInt(entry + 8));
+        const auto stateSize = static_cast<size_t>(juce::ByteOrder::littleEndianInt(entry + 12));
+
+        if (! isInside(nameOffset, nameLength, fileSize) || ! isInside(stateOffset, stateSize, fileSize)
+            || nameLength > 1024 || stateSize > static_cast<size_t>(std::numeric_limits<int>::max()))
+            return nullptr;
+
+        // Decoded once here, so switching never parses
+        if (! StateFormat::readNormalisedValues(processor, bytes + stateOffset, static_cast<int>(stateSize),
+                                                bank->values.data() + static_cast<size_t>(program) * static_cast<size_t>(bank->numParameters)))
+            return nullptr;
+
+        bank->names.push_back({ bytes + nameOffset, static_cast<int>(nameLength) });
+    }
+
+    bank->mapping = std::move(mapping);
+    return bank;
+}
+
+bool PresetBank::write(const juce::File& file, const juce::Array<Program>& programs)
+{
+    if (programs.isEmpty() || programs.size() > maxPrograms)
+        return false;
+
+    // Names and states follow the directory, in program order
+    juce::MemoryBlock bankData;
+    juce::MemoryOutputStream out(bankData, false);
+
+    out.writeInt(static_cast<int>(magic));
+    out.writeShort(static_cast<short>(currentVersion));
+    out.writeShort(static_cast<short>(programs.size()));
+
+    auto offset = headerSize + static_cast<size_t>(programs.size()) * entrySize;
+
+    for (const auto& program : programs)
+    {
+        const auto nameLength = program.name.getNumBytesAsUTF8();
+        out.writeInt(static_cast<int>(offset));
+        out.writeInt(static_cast<int>(nameLength));
+        offset += nameLength;
+
+        out.writeInt(static_cast<int>(offset));
+        out.writeInt(static_cast<int>(program.state.getSize()));
+        offset += program.state.getSize();
+    }
+
+    for (const auto& program : programs)
+    {
+        out.write(program.name.toRawUTF8(), program.name.getNumBytesAsUTF8());
+        out << program.state;
+    }
+
+    out.flush();
+
+    // Banks may be mapped by running instances; never truncate one in place
+    juce::TemporaryFile temporary(file);
+
+    return temporary.getFile().replaceWithData(bankData.getData(), bankData.getSize())
+        && temporary.overwriteTargetFileWithTemporary();
+}
+
+//==============================================================================
+juce::String PresetBank::getProgramName(int index) const
+{
+    if (! isValidProgram(index))
+        return {};
+
+    const auto& name = names[static_cast<size_t>(index)];
+    return juce::String::fromUTF8(name.text, name.length);
+}
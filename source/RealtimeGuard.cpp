@@ -0,0 +1,234 @@
+#include <juce_core/juce_core.h>
+#include "../include/RealtimeGuard.h"
+
+#if PLUGIN_REALTIME_CHECKS
+
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#if JUCE_LINUX
+ #include <dlfcn.h>
+ #include <pthread.h>
+ #include <time.h>
+ #include <unistd.h>
+#endif
+
+namespace RealtimeGuard
+{
+namespace
+{
+    // Constant-initialised, so it is safe to read from inside operator new
+    thread_local bool realtimeThread = false;
+}
+
+//==============================================================================
+ScopedRealtimeScope::ScopedRealtimeScope() noexcept
+    : wasActive(realtimeThread)
+{
+    realtimeThread = true;
+}
+
+ScopedRealtimeScope::~ScopedRealtimeScope() noexcept
+{
+    realtimeThread = wasActive;
+}
+
+ScopedRealtimeExemption::ScopedRealtimeExemption() noexcept
+    : wasActive(realtimeThread)
+{
+    realtimeThread = false;
+}
+
+ScopedRealtimeExemption::~ScopedRealtimeExemption() noexcept
+{
+    realtimeThread = wasActive;
+}
+
+bool isActive() noexcept
+{
+    return realtimeThread;
+}
+
+void reportViolation(const char* operation) noexcept
+{
+    // Everything below allocates, so stop checking before doing any of it
+    realtimeThread = false;
+
+    std::fprintf(stderr, "\n*** Realtime violation: %s called inside processBlock\n%s\n",
+                 operation, juce::SystemStats::getStackBacktrace().toRawUTF8());
+    std::fflush(stderr);
+    std::abort();
+}
+}
+
+//==============================================================================
+// Allocation hooks
+namespace
+{
+    void checkRealtime(const char* operation) noexcept
+    {
+        if (RealtimeGuard::isActive())
+            RealtimeGuard::reportViolation(operation);
+    }
+
+    void* allocate(std::size_t size) noexcept
+    {
+        return std::malloc(size == 0 ? 1 : size);
+    }
+
+    void* allocateAligned(std::size_t size, std::align_val_t alignment) noexcept
+    {
+       #if JUCE_WINDOWS
+        return _aligned_malloc(size == 0 ? 1 : size, static_cast<std::size_t>(alignment));
+       #else
+        void* result = nullptr;
+        const auto align = juce::jmax(sizeof(void*), static_cast<std::size_t>(alignment));
+        return posix_memalign(&result, align, size == 0 ? 1 : size) == 0 ? result : nullptr;
+       #endif
+    }
+
+    void freeAligned(void* pointer) noexcept
+    {
+       #if JUCE_WINDOWS
+        _aligned_free(pointer);
+       #else
+        std::free(pointer);
+       #endif
+    }
+
+    void check(void* pointer, const char* operation) noexcept
+    {
+        if (pointer != nullptr)
+            checkRealtime(operation);
+    }
+}
+
+void* operator new(std::size_t size)
+{
+    checkRealtime("operator new");
+
+    if (auto* pointer = allocate(size))
+        return pointer;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    checkRealtime("operator new[]");
+
+    if (auto* pointer = allocate(size))
+        return pointer;
+
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    checkRealtime("operator new");
+
+    if (auto* pointer = allocateAligned(size, alignment))
+        return pointer;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+    checkRealtime("operator new[]");
+
+    if (auto* pointer = allocateAligned(size, alignment))
+        return pointer;
+
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept                                  { checkRealtime("operator new"); return allocate(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept                                { checkRealtime("operator new[]"); return allocate(size); }
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept      { checkRealtime("operator new"); return allocateAligned(size, alignment); }
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept    { checkRealtime("operator new[]"); return allocateAligned(size, alignment); }
+
+void operator delete(void* pointer) noexcept                                                          { check(pointer, "operator delete"); std::free(pointer); }
+void operator delete[](void* pointer) noexcept                                                        { check(pointer, "operator delete[]"); std::free(pointer); }
+void operator delete(void* pointer, std::size_t) noexcept                                             { check(pointer, "operator delete"); std::free(pointer); }
+void operator delete[](void* pointer, std::size_t) noexcept                                           { check(pointer, "operator delete[]"); std::free(pointer); }
+void operator delete(void* pointer, const std::nothrow_t&) noexcept                                   { check(pointer, "operator delete"); std::free(pointer); }
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept                                 { check(pointer, "operator delete[]"); std::free(pointer); }
+void operator delete(void* pointer, std::align_val_t) noexcept                                        { check(pointer, "operator delete"); freeAligned(pointer); }
+void operator delete[](void* pointer, std::align_val_t) noexcept                                      { check(pointer, "operator delete[]"); freeAligned(pointer); }
+void operator delete(void* pointer, std::size_t, std::align_val_t) noexcept                           { check(pointer, "operator delete"); freeAligned(pointer); }
+void operator delete[](void* pointer, std::size_t, std::align_val_t) noexcept                         { check(pointer, "operator delete[]"); freeAligned(pointer); }
+void operator delete(void* pointer, std::align_val_t, const std::nothrow_t&) noexcept                 { check(pointer, "operator delete"); freeAligned(pointer); }
+void operator delete[](void* pointer, std::align_val_t, const std::nothrow_t&) noexcept               { check(pointer, "operator delete[]"); freeAligned(pointer); }
+
+//==============================================================================
+// Blocking hooks. Linux resolves these symbols to the first definition, so
+// ours run for the whole process and forward to libc/libpthread. Other
+// platforms only get the allocation checks.
+#if JUCE_LINUX
+namespace
+{
+    template <typename Function>
+    Function findNext(const char* name) noexcept
+    {
+        return reinterpret_cast<Function>(dlsym(RTLD_NEXT, name));
+    }
+
+    // glibc keeps a pre-2.3.2 condition variable ABI under the unversioned
+    // name, so ask for the current one explicitly. Targets whose first glibc
+    // came later only have one version, which plain dlsym finds.
+    template <typename Function>
+    Function findNextCondition(const char* name) noexcept
+    {
+       #if defined (__GLIBC__)
+        if (auto* symbol = dlvsym(RTLD_NEXT, name, "GLIBC_2.3.2"))
+            return reinterpret_cast<Function>(symbol);
+       #endif
+
+        return findNext<Function>(name);
+    }
+}
+
+extern "C" int pthread_mutex_lock(pthread_mutex_t* mutex)
+{
+    checkRealtime("pthread_mutex_lock");
+
+    static const auto next = findNext<int (*)(pthread_mutex_t*)>("pthread_mutex_lock");
+    return next(mutex);
+}
+
+extern "C" int pthread_cond_wait(pthread_cond_t* condition, pthread_mutex_t* mutex)
+{
+    checkRealtime("pthread_cond_wait");
+
+    static const auto next = findNextCondition<int (*)(pthread_cond_t*, pthread_mutex_t*)>("pthread_cond_wait");
+    return next(condition, mutex);
+}
+
+extern "C" int pthread_cond_timedwait(pthread_cond_t* condition, pthread_mutex_t* mutex, const struct timespec* deadline)
+{
+    checkRealtime("pthread_cond_timedwait");
+
+    static const auto next = findNextCondition<int (*)(pthread_cond_t*, pthread_mutex_t*, const struct timespec*)>("pthread_cond_timedwait");
+    return next(condition, mutex, deadline);
+}
+
+extern "C" int nanosleep(const struct timespec* duration, struct timespec* remaining)
+{
+    checkRealtime("nanosleep");
+
+    static const auto next = findNext<int (*)(const struct timespec*, struct timespec*)>("nanosleep");
+    return next(duration, remaining);
+}
+
+extern "C" int usleep(useconds_t microseconds)
+{
+    checkRealtime("usleep");
+
+    static const auto next = findNext<int (*)(useconds_t)>("usleep");
+    return next(microseconds);
+}
+#endif
+
+#endif // PLUGIN_REALTIME_CHECKS
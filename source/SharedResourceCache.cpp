@@ -0,0 +1,49 @@
+#include "../include/SharedResourceCache.h"
+
+//==============================================================================
+std::shared_ptr<const void> SharedResourceCache::find(const EntryKey& key)
+{
+    const juce::ScopedLock scopedLock(lock);
+    const auto entry = entries.find(key);
+
+    return entry != entries.end() ? entry->second.lock() : std::shared_ptr<const void>();
+}
+
+std::shared_ptr<const void> SharedResourceCache::store(const EntryKey& key, std::shared_ptr<const void> resource)
+{
+    const juce::ScopedLock scopedLock(lock);
+
+    // Drop entries whose last user has gone, so the map stays the size of what's alive
+    for (auto entry = entries.begin(); entry != entries.end();)
+        entry = entry->second.expired() ? entries.erase(entry) : std::next(entry);
+
+    auto& slot = entries[key];
+
+    if (auto existing = slot.lock())
+        return existing;
+
+    slot = resource;
+    return resource;
+}
+
+int SharedResourceCache::getNumResources() const
+{
+    const juce::ScopedLock scopedLock(lock);
+    int numAlive = 0;
+
+    for (const auto& entry : entries)
+        numAlive += entry.second.expired() ? 0 : 1;
+
+    return numAlive;
+}
+
+juce::uint64 SharedResourceCache::hashBytes(const void* data, size_t numBytes, juce::uint64 seed) noexcept
+{
+    auto hash = seed;
+    const auto* bytes = static_cast<const juce::uint8*>(data);
+
+    for (size_t i = 0; i < numBytes; ++i)
+        hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+
+    return hash;
+}
@@ -0,0 +1,304 @@
+#include "../include/StateFormat.h"
+#include <cmath>
+#include <vector>
+
+namespace StateFormat
+{
+namespace
+{
+    constexpr int headerSize = 8;
+
+    juce::RangedAudioParameter* asRanged(juce::AudioProcessorParameter* parameter) noexcept
+    {
+        return dynamic_cast<juce::RangedAudioParameter*>(parameter);
+    }
+
+    struct MidiMapping
+    {
+        int midiChannel, controller, parameterIndex;
+    };
+
+    void writeId(juce::MemoryOutputStream& out, const juce::RangedAudioParameter& parameter)
+    {
+        auto id = parameter.getParameterID().toRawUTF8();
+        const auto idLength = juce::jmin(static_cast<int>(std::strlen(id)), 255);
+
+        out.writeByte(static_cast<char>(idLength));
+        out.write(id, static_cast<size_t>(idLength));
+    }
+
+    void patchCount(juce::MemoryBlock& destData, size_t offset, juce::uint16 count) noexcept
+    {
+        auto* countField = static_cast<char*>(destData.getData()) + offset;
+        countField[0] = static_cast<char>(count & 0xff);
+        countField[1] = static_cast<char>(count >> 8);
+    }
+
+    /**
+     * The ranged parameter with this ID, and its index; hintIndex is tried
+     * first, since states are written in parameter order.
+     */
+    juce::RangedAudioParameter* findParameter(const juce::AudioProcessor& processor, const char* id, int idLength,
+                                              int hintIndex, int& foundIndex)
+    {
+        const auto& parameters = processor.getParameters();
+
+        auto matches = [&](juce::AudioProcessorParameter* parameter) -> juce::RangedAudioParameter*
+        {
+            auto* ranged = asRanged(parameter);
+            if (ranged == nullptr)
+                return nullptr;
+
+            // IDs are stored as UTF-8 inside juce::String, so this doesn't allocate
+            auto candidate = ranged->getParameterID().toRawUTF8();
+            return std::strlen(candidate) == static_cast<size_t>(idLength) && std::memcmp(candidate, id, static_cast<size_t>(idLength)) == 0
+                       ? ranged : nullptr;
+        };
+
+        foundIndex = hintIndex;
+        auto* target = juce::isPositiveAndBelow(hintIndex, parameters.size()) ? matches(parameters.getUnchecked(hintIndex)) : nullptr;
+
+        for (int j = 0; target == nullptr && j < parameters.size(); ++j)
+            if ((target = matches(parameters.getUnchecked(j))) != nullptr)
+                foundIndex = j;
+
+        return target;
+    }
+
+    template <typename ValueGetter>
+    void writeParameters(const juce::AudioProcessor& processor, juce::MemoryBlock& destData,
+                         const MidiControlMap* midiMappings, ValueGetter&& getNormalisedValue)
+    {
+        const auto& parameters = processor.getParameters();
+
+        destData.reset();
+        juce::MemoryOutputStream out(destData, false);
+        out.preallocate(static_cast<size_t>(headerSize + parameters.size() * 24));
+
+        out.writeInt(static_cast<int>(magic));
+        out.writeShort(static_cast<short>(currentVersion));
+        out.writeShort(0); // patched below once the count is known
+
+        juce::uint16 numWritten = 0;
+
+        for (int index = 0; index < parameters.size(); ++index)
+        {
+            auto* ranged = asRanged(parameters.getUnchecked(index));
+            if (ranged == nullptr)
+                continue;
+
+            writeId(out, *ranged);
+            out.writeFloat(ranged->convertFrom0to1(getNormalisedValue(index, *ranged)));
+            ++numWritten;
+        }
+
+        // Only written when there are assignments, so states without them are unchanged
+        size_t mappingCountOffset = 0;
+        juce::uint16 numMappingsWritten = 0;
+
+        if (midiMappings != nullptr && midiMappings->getNumMappings() > 0)
+        {
+            out.writeInt(static_cast<int>(midiMappingsTag));
+            mappingCountOffset = static_cast<size_t>(out.getPosition());
+            out.writeShort(0);
+
+            midiMappings->forEachMapping([&](int midiChannel, int controller, int parameterIndex)
+            {
+                auto* ranged = juce::isPositiveAndBelow(parameterIndex, parameters.size())
+                                   ? asRanged(parameters.getUnchecked(parameterIndex)) : nullptr;
+                if (ranged == nullptr)
+                    return;
+
+                out.writeByte(static_cast<char>(midiChannel));
+                out.writeByte(static_cast<char>(controller));
+                writeId(out, *ranged);
+                ++numMappingsWritten;
+            });
+        }
+
+        out.flush();
+
+        patchCount(destData, 6, numWritten);
+
+        if (mappingCountOffset != 0)
+            patchCount(destData, mappingCountOffset, numMappingsWritten);
+    }
+
+    /**
+     * Calls apply(index, parameter, value) for every stored value whose ID
+     * this build knows, and returns where the values end. Returns nullptr on
+     * a truncated state, possibly after some calls, so callers decode into a
+     * copy.
+     */
+    template <typename Apply>
+    const char* parseValues(const juce::AudioProcessor& processor, const void* data, int sizeInBytes, Apply&& apply)
+    {
+        if (! isBinaryState(data, sizeInBytes))
+            return nullptr;
+
+        auto* bytes = static_cast<const char*>(data);
+        const auto* end = bytes + sizeInBytes;
+        const auto numParameters = juce::ByteOrder::littleEndianShort(bytes + 6);
+        const auto* cursor = bytes + headerSize;
+
+        for (int i = 0; i < static_cast<int>(numParameters); ++i)
+        {
+            if (end - cursor < 1)
+                return nullptr;
+
+            const auto idLength = static_cast<juce::uint8>(*cursor++);
+
+            if (end - cursor < idLength + 4)
+                return nullptr;
+
+            const auto* id = cursor;
+            cursor += idLength;
+
+            const auto rawValue = juce::ByteOrder::littleEndianInt(cursor);
+            cursor += 4;
+
+            float value;
+            std::memcpy(&value, &rawValue, sizeof(value));
+
+            // States are written in parameter order, so the same index nearly always matches
+            int targetIndex = i;
+            auto* target = findParameter(processor, id, idLength, i, targetIndex);
+
+            // A non-finite value keeps the parameter's current one, like an unknown ID
+            if (target != nullptr && std::isfinite(value))
+                apply(targetIndex, *target, value);
+        }
+
+        return cursor;
+    }
+
+    /**
+     * Reads the MIDI assignments that may follow the values, from cursor up
+     * to end, skipping those for unknown IDs. Data that isn't an assignment
+     * chunk is ignored; returns false if the chunk is truncated.
+     */
+    bool parseMidiMappings(const juce::AudioProcessor& processor, const char* cursor, const char* end,
+                           std::vector<MidiMapping>& mappings)
+    {
+        if (end - cursor < 6 || juce::ByteOrder::littleEndianInt(cursor) != midiMappingsTag)
+            return true;
+
+        const auto numMappings = juce::ByteOrder::littleEndianShort(cursor + 4);
+        cursor += 6;
+
+        for (int i = 0; i < static_cast<int>(numMappings); ++i)
+        {
+            if (end - cursor < 3)
+                return false;
+
+            const auto midiChannel = static_cast<int>(static_cast<juce::uint8>(cursor[0]));
+            const auto controller = static_cast<int>(static_cast<juce::uint8>(cursor[1]));
+            const auto idLength = static_cast<juce::uint8>(cursor[2]);
+            cursor += 3;
+
+            if (end - cursor < idLength)
+                return false;
+
+            int parameterIndex = 0;
+
+            if (findParameter(processor, cursor, idLength, 0, parameterIndex) != nullptr)
+                mappings.push_back({ midiChannel, controller, parameterIndex });
+
+            cursor += idLength;
+        }
+
+        return true;
+    }
+}
+
+//==============================================================================
+bool isBinaryState(const void* data, int sizeInBytes) noexcept
+{
+    if (data == nullptr || sizeInBytes < headerSize)
+        return false;
+
+    auto* bytes = static_cast<const char*>(data);
+    const auto version = juce::ByteOrder::littleEndianShort(bytes + 4);
+
+    return juce::ByteOrder::littleEndianInt(bytes) == magic
+        && version >= 1 && version <= currentVersion;
+}
+
+void write(const juce::AudioProcessor& processor, juce::MemoryBlock& destData, const MidiControlMap* midiMappings)
+{
+    writeParameters(processor, destData, midiMappings, [](int, const juce::RangedAudioParameter& parameter)
+    {
+        return parameter.getValue();
+    });
+}
+
+void write(const juce::AudioProcessor& processor, const float* normalisedValues, juce::MemoryBlock& destData,
+           const MidiControlMap* midiMappings)
+{
+    writeParameters(processor, destData, midiMappings, [normalisedValues](int index, const juce::RangedAudioParameter&)
+    {
+        return normalisedValues[index];
+    });
+}
+
+bool read(juce::AudioProcessor& processor, const void* data, int sizeInBytes, MidiControlMap* midiMappings)
+{
+    const auto& parameters = processor.getParameters();
+    std::vector<float> values(static_cast<size_t>(parameters.size()));
+
+    for (int index = 0; index < parameters.size(); ++index)
+        values[static_cast<size_t>(index)] = parameters.getUnchecked(index)->getValue();
+
+    const auto* valuesEnd = parseValues(processor, data, sizeInBytes, [&values](int index, juce::RangedAudioParameter& parameter, float value)
+    {
+        values[static_cast<size_t>(index)] = parameter.convertTo0to1(value);
+    });
+
+    if (valuesEnd == nullptr)
+        return false;
+
+    std::vector<MidiMapping> mappings;
+
+    if (midiMappings != nullptr
+        && ! parseMidiMappings(processor, valuesEnd, static_cast<const char*>(data) + sizeInBytes, mappings))
+        return false;
+
+    // Only applied once the whole state has decoded
+    for (int index = 0; index < parameters.size(); ++index)
+    {
+        auto* ranged = asRanged(parameters.getUnchecked(index));
+        const auto value = values[static_cast<size_t>(index)];
+
+        if (ranged != nullptr && value != ranged->getValue())
+            ranged->setValueNotifyingHost(value);
+    }
+
+    if (midiMappings != nullptr)
+    {
+        midiMappings->clearAll();
+
+        for (const auto& mapping : mappings)
+            midiMappings->setMapping(mapping.midiChannel, mapping.controller, mapping.parameterIndex);
+    }
+
+    return true;
+}
+
+bool readNormalisedValues(const juce::AudioProcessor& processor, const void* data, int sizeInBytes,
+                          float* normalisedValues)
+{
+    // Decoded into a copy, so a state that turns out to be truncated changes nothing
+    std::vector<float> decoded(normalisedValues, normalisedValues + processor.getParameters().size());
+
+    const auto parsed = parseValues(processor, data, sizeInBytes, [&decoded](int index, juce::RangedAudioParameter& parameter, float value)
+    {
+        decoded[static_cast<size_t>(index)] = parameter.convertTo0to1(value);
+    });
+
+    if (parsed == nullptr)
+        return false;
+
+    std::copy(decoded.begin(), decoded.end(), normalisedValues);
+    return true;
+}
+}
@@ -0,0 +1,385 @@
+#include "../include/WorkerPool.h"
+
+#if JUCE_WINDOWS
+ #ifndef NOMINMAX
+  #define NOMINMAX
+ #endif
+ #include <windows.h>
+#elif JUCE_MAC || JUCE_IOS
+ #include <mach/mach.h>
+#else
+ #include <cerrno>
+ #include <semaphore.h>
+#endif
+
+#if JUCE_INTEL
+ #include <immintrin.h>
+#endif
+
+namespace
+{
+    inline void cpuRelax() noexcept
+    {
+#if JUCE_INTEL
+        _mm_pause();
+#elif JUCE_ARM && (JUCE_GCC || JUCE_CLANG)
+        __asm__ __volatile__("yield");
+#endif
+    }
+
+    constexpr juce::uint64 makeClaimWord(int numTasks) noexcept
+    {
+        return static_cast<juce::uint64>(numTasks) << 32;
+    }
+
+    constexpr int jobNumberShift = 8;
+
+    constexpr juce::uint64 makeJobWord(juce::uint64 jobNumber, int numTasks) noexcept
+    {
+        return (jobNumber << jobNumberShift) | static_cast<juce::uint64>(numTasks);
+    }
+
+#if JUCE_WINDOWS
+    /** Registers the calling thread with MMCSS for the lifetime of the object. */
+    class ScopedMmcssRegistration
+    {
+    public:
+        ScopedMmcssRegistration()
+        {
+            // avrt.dll is loaded at runtime so the plugin doesn't link against it
+            if (avrt.open("avrt.dll"))
+            {
+                using SetFn = HANDLE(WINAPI*)(LPCWSTR, LPDWORD);
+                using RevertFn = BOOL(WINAPI*)(HANDLE);
+
+                auto set = reinterpret_cast<SetFn>(avrt.getFunction("AvSetMmThreadCharacteristicsW"));
+                revert = reinterpret_cast<RevertFn>(avrt.getFunction("AvRevertMmThreadCharacteristics"));
+
+                DWORD taskIndex = 0;
+
+                if (set != nullptr)
+                    handle = set(L"Pro Audio", &taskIndex);
+            }
+        }
+
+        ~ScopedMmcssRegistration()
+        {
+            if (handle != nullptr && revert != nullptr)
+                revert(handle);
+        }
+
+    private:
+        juce::DynamicLibrary avrt;
+        HANDLE handle = nullptr;
+        BOOL(WINAPI* revert)(HANDLE) = nullptr;
+    };
+#endif
+}
+
+//==============================================================================
+/** Counting semaphore whose signal side is a single syscall, never a mutex. */
+class WorkerPool::Semaphore
+{
+public:
+    Semaphore()
+    {
+#if JUCE_WINDOWS
+        handle = CreateSemaphoreW(nullptr, 0, LONG_MAX, nullptr);
+#elif JUCE_MAC || JUCE_IOS
+        semaphore_create(mach_task_self(), &semaphore, SYNC_POLICY_FIFO, 0);
+#else
+        sem_init(&semaphore, 0, 0);
+#endif
+    }
+
+    ~Semaphore()
+    {
+#if JUCE_WINDOWS
+        CloseHandle(handle);
+#elif JUCE_MAC || JUCE_IOS
+        semaphore_destroy(mach_task_self(), semaphore);
+#else
+        sem_destroy(&semaphore);
+#endif
+    }
+
+    void signal(int count) noexcept
+    {
+#if JUCE_WINDOWS
+        ReleaseSemaphore(handle, count, nullptr);
+#else
+        for (int i = 0; i < count; ++i)
+ #if JUCE_MAC || JUCE_IOS
+            semaphore_signal(semaphore);
+ #else
+            sem_post(&semaphore);
+ #endif
+#endif
+    }
+
+    void wait() noexcept
+    {
+#if JUCE_WINDOWS
+        WaitForSingleObject(handle, INFINITE);
+#elif JUCE_MAC || JUCE_IOS
+        while (semaphore_wait(semaphore) == KERN_ABORTED) {}
+#else
+        while (sem_wait(&semaphore) != 0 && errno == EINTR) {}
+#endif
+    }
+
+private:
+#if JUCE_WINDOWS
+    HANDLE handle = nullptr;
+#elif JUCE_MAC || JUCE_IOS
+    semaphore_t semaphore {};
+#else
+    sem_t semaphore {};
+#endif
+
+    JUCE_DECLARE_NON_COPYABLE(Semaphore)
+};
+
+//==============================================================================
+class WorkerPool::Worker : public juce::Thread
+{
+public:
+    Worker(WorkerPool& owner, int index)
+        : juce::Thread("Audio worker " + juce::String(index + 1)), pool(owner)
+    {
+    }
+
+    void run() override { pool.workerLoop(*this); }
+
+    juce::WorkgroupToken workgroupToken;
+    int seenWorkgroupGeneration = 0;
+
+private:
+    WorkerPool& pool;
+};
+
+//==============================================================================
+WorkerPool::WorkerPool(int numWorkers)
+    : wake(std::make_unique<Semaphore>())
+{
+    numWorkers = juce::jlimit(1, maxWorkers, numWorkers);
+
+    for (int i = 0; i < numWorkers; ++i)
+    {
+        auto worker = std::make_unique<Worker>(*this, i);
+
+        // Without realtime permissions (e.g. Linux without rtprio) use the
+        // highest normal priority rather than not starting at all
+        if (! worker->startRealtimeThread(juce::Thread::RealtimeOptions {}))
+            worker->startThread(juce::Thread::Priority::highest);
+
+        workers.push_back(std::move(worker));
+    }
+}
+
+WorkerPool::~WorkerPool()
+{
+    shouldExit.store(true, std::memory_order_release);
+    wake->signal(getNumWorkers());
+
+    for (auto& worker : workers)
+        worker->stopThread(1000);
+
+    workers.clear();
+}
+
+void WorkerPool::setWorkgroup(const juce::AudioWorkgroup& newWorkgroup)
+{
+    {
+        const juce::SpinLock::ScopedLockType lock(workgroupLock);
+        workgroup = newWorkgroup;
+    }
+
+    workgroupGeneration.fetch_add(1, std::memory_order_release);
+}
+
+//==============================================================================
+void WorkerPool::run(int numTasks, Task task, void* context, juce::int64 deadlineTicks) noexcept
+{
+    if (numTasks <= 0)
+        return;
+
+    auto runInline = [&]
+    {
+        for (int i = 0; i < numTasks; ++i)
+            task(context, i);
+    };
+
+    // One task, too many to track, or the workers recently missed their deadline: nothing to share
+    if (numTasks == 1 || numTasks > maxTasks || fallbackRunsLeft > 0)
+    {
+        if (fallbackRunsLeft > 0)
+        {
+            --fallbackRunsLeft;
+            inlineRuns.store(inlineRuns.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+
+        runInline();
+        return;
+    }
+
+    // Publish the job; the job word's release orders the fields before it,
+    // and the claim word is only handed out once both are visible
+    jobTask.store(task, std::memory_order_relaxed);
+    jobContext.store(context, std::memory_order_relaxed);
+    remainingTasks.store(numTasks, std::memory_order_relaxed);
+    jobWord.store(makeJobWord(++jobNumber, numTasks), std::memory_order_release);
+    claimWord.store(makeClaimWord(numTasks), std::memory_order_release);
+
+    wake->signal(juce::jmin(numTasks - 1, getNumWorkers()));
+
+    // Work alongside the workers until every task has been claimed
+    auto ranHere = runClaimedTasks();
+
+    // Then wait for tasks claimed by a worker. Past the deadline, take back
+    // any that haven't started and wait only for those already running.
+    const auto deadline = juce::Time::getHighResolutionTicks() + deadlineTicks;
+    bool missedDeadline = false;
+
+    while (remainingTasks.load(std::memory_order_acquire) > 0)
+    {
+        if (! missedDeadline && juce::Time::getHighResolutionTicks() > deadline)
+        {
+            missedDeadline = true;
+            ranHere += runUnstartedTasks();
+            continue;
+        }
+
+        cpuRelax();
+    }
+
+    claimWord.store(0, std::memory_order_relaxed);
+
+    parallelRuns.store(parallelRuns.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    tasksOnCaller.store(tasksOnCaller.load(std::memory_order_relaxed) + static_cast<juce::uint64>(ranHere),
+                        std::memory_order_relaxed);
+
+    if (missedDeadline)
+    {
+        deadlineMisses.store(deadlineMisses.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+        if (++missesInWindow >= missesBeforeFallback)
+        {
+            fallbackRunsLeft = fallbackRuns;
+            missesInWindow = runsInWindow = 0;
+            return;
+        }
+    }
+
+    if (++runsInWindow >= missWindowRuns)
+        missesInWindow = runsInWindow = 0;
+}
+
+int WorkerPool::runClaimedTasks() noexcept
+{
+    int numRun = 0;
+
+    for (;;)
+    {
+        const auto claim = claimWord.fetch_add(1, std::memory_order_acq_rel);
+        const auto numTasks = static_cast<int>(claim >> 32);
+        const auto index = static_cast<int>(claim & 0xffffffffu);
+
+        if (index >= numTasks)
+            return numRun;
+
+        if (tryRunTask(index))
+            ++numRun;
+    }
+}
+
+int WorkerPool::runUnstartedTasks() noexcept
+{
+    const auto numTasks = static_cast<int>(jobWord.load(std::memory_order_relaxed) & 0xffu);
+    int numRun = 0;
+
+    for (int i = 0; i < numTasks; ++i)
+        if (tryRunTask(i))
+            ++numRun;
+
+    return numRun;
+}
+
+bool WorkerPool::tryRunTask(int index) noexcept
+{
+    // A claim may be from a job that has since finished; the job word says
+    // which one is current, and that job can't finish while this task is unstarted
+    const auto job = jobWord.load(std::memory_order_acquire);
+    const auto number = job >> jobNumberShift;
+
+    if (index >= static_cast<int>(job & 0xffu))
+        return false;
+
+    auto& started = taskStarted[static_cast<size_t>(index)];
+    auto lastStarted = started.load(std::memory_order_relaxed);
+
+    do
+    {
+        if (lastStarted >= number)
+            return false;
+    }
+    while (! started.compare_exchange_weak(lastStarted, number, std::memory_order_acq_rel, std::memory_order_relaxed));
+
+    // Winning the start flag keeps the job (and these fields) alive until it's reported done
+    jobTask.load(std::memory_order_relaxed)(jobContext.load(std::memory_order_relaxed), index);
+    remainingTasks.fetch_sub(1, std::memory_order_release);
+    return true;
+}
+
+void WorkerPool::workerLoop(Worker& worker)
+{
+    // Tasks run JUCE stages (the convolution) that rely on FTZ/DAZ, as on the audio thread
+    const juce::ScopedNoDenormals noDenormals;
+
+#if JUCE_WINDOWS
+    const ScopedMmcssRegistration mmcss;
+#endif
+
+    for (;;)
+    {
+        wake->wait();
+
+        if (shouldExit.load(std::memory_order_acquire))
+            break;
+
+        if (worker.seenWorkgroupGeneration != workgroupGeneration.load(std::memory_order_acquire))
+            updateWorkgroup(worker);
+
+        if (const auto numRun = runClaimedTasks(); numRun > 0)
+            tasksOnWorkers.fetch_add(static_cast<juce::uint64>(numRun), std::memory_order_relaxed);
+    }
+
+    worker.workgroupToken.reset();
+}
+
+void WorkerPool::updateWorkgroup(Worker& worker)
+{
+    juce::AudioWorkgroup current;
+
+    {
+        const juce::SpinLock::ScopedLockType lock(workgroupLock);
+        current = workgroup;
+        worker.seenWorkgroupGeneration = workgroupGeneration.load(std::memory_order_relaxed);
+    }
+
+    worker.workgroupToken.reset();
+
+    if (current)
+        current.join(worker.workgroupToken);
+}
+
+WorkerPool::Stats WorkerPool::getStats() const noexcept
+{
+    Stats stats;
+    stats.parallelRuns = parallelRuns.load(std::memory_order_relaxed);
+    stats.inlineRuns = inlineRuns.load(std::memory_order_relaxed);
+    stats.deadlineMisses = deadlineMisses.load(std::memory_order_relaxed);
+    stats.tasksOnWorkers = tasksOnWorkers.load(std::memory_order_relaxed);
+    stats.tasksOnCaller = tasksOnCaller.load(std::memory_order_relaxed);
+    return stats;
+}